@@ -43,8 +43,10 @@ void Adafruit_SSD1331::setAddrWindow(uint16_t x, uint16_t y, uint16_t w,
   // The inputs to this will _always_ be pre-clipped
 
   // True if we're swapping row and column due to rotation
-  bool swap = rotation & 0x01;
+  bool swap = swapXY();
 
+  HookScope hook(this, SSD1331_STAT_WINDOW, w, h, SSD1331_BYTES_WINDOW);
+  statBegin(SSD1331_STAT_WINDOW);
   SPI_DC_LOW();  // enter command mode
 
   spiWrite(swap?SSD1331_CMD_SETROW:SSD1331_CMD_SETCOLUMN);
@@ -56,6 +58,14 @@ void Adafruit_SSD1331::setAddrWindow(uint16_t x, uint16_t y, uint16_t w,
   spiWrite(y + h - 1);
 
   SPI_DC_HIGH(); // exit command mode
+  statPhase(SSD1331_STAT_PIXELS);
+
+  // Remember where pixel data will land, for the dither pattern.
+  run_x = -1;
+  win_x = x;
+  win_w = w;
+  win_col = 0;
+  win_row = y;
 }
 
 /**************************************************************************/
@@ -71,19 +81,40 @@ static const uint8_t SETREMAP_COLOR_BITS = 0b01100000; // 0x72 - RGB Color
 static const uint8_t SETREMAP_COLOR_BITS = 0b01100100; // 0x76 - BGR Color
 #endif
 
+// Bit 2 of the setremap command swaps the order of the color channels, for
+// pixel data and the drawing engine alike
+static const uint8_t SETREMAP_ORDER_BGR = 0b00000100;
+
+// Bits 7:6 of the setremap command select the pixel data format
+static const uint8_t SETREMAP_FORMAT_MASK = 0b11000000;
+static const uint8_t SETREMAP_FORMAT_65K = 0b01000000;
+static const uint8_t SETREMAP_FORMAT_256 = 0b00000000;
+
 // These are the bits to OR into the setremap command for different rotations
 static const uint8_t SETREMAP_ROTATION_0_BITS = 0b00010010;
 static const uint8_t SETREMAP_ROTATION_1_BITS = 0b00000011;
 static const uint8_t SETREMAP_ROTATION_2_BITS = 0b00000000;
 static const uint8_t SETREMAP_ROTATION_3_BITS = 0b00010001;
 
+// The rotation begin() sets up
+#if !defined(SSD1331_FIXED_ROTATION) || SSD1331_FIXED_ROTATION == 0
+static const uint8_t SETREMAP_INIT_ROTATION_BITS = SETREMAP_ROTATION_0_BITS;
+#elif SSD1331_FIXED_ROTATION == 1
+static const uint8_t SETREMAP_INIT_ROTATION_BITS = SETREMAP_ROTATION_1_BITS;
+#elif SSD1331_FIXED_ROTATION == 2
+static const uint8_t SETREMAP_INIT_ROTATION_BITS = SETREMAP_ROTATION_2_BITS;
+#else
+static const uint8_t SETREMAP_INIT_ROTATION_BITS = SETREMAP_ROTATION_3_BITS;
+#endif
+
 void Adafruit_SSD1331::begin(uint32_t freq) {
   initSPI(freq);
+  run_x = -1; // A reset closes any address window the chip had open
 
   // Initialization Sequence
   sendCommand(SSD1331_CMD_DISPLAYOFF); // 0xAE
   sendCommand(SSD1331_CMD_SETREMAP);   // 0xA0
-  sendCommand(SETREMAP_COLOR_BITS|SETREMAP_ROTATION_0_BITS);
+  sendCommand(remapColorBits|SETREMAP_INIT_ROTATION_BITS);
   sendCommand(SSD1331_CMD_STARTLINE); // 0xA1
   sendCommand(0x0);
   sendCommand(SSD1331_CMD_DISPLAYOFFSET); // 0xA2
@@ -121,6 +152,29 @@ void Adafruit_SSD1331::begin(uint32_t freq) {
   sendCommand(SSD1331_CMD_DISPLAYON); //--turn on oled panel
   _width = TFTWIDTH;
   _height = TFTHEIGHT;
+#ifdef SSD1331_FIXED_ROTATION
+  rotation = SSD1331_FIXED_ROTATION;
+  if (rotation & 1) {
+    _width = TFTHEIGHT;
+    _height = TFTWIDTH;
+  }
+#endif
+}
+
+/**************************************************************************/
+/*!
+    @brief  Initialize SSD1331 chip for a panel with the given color order,
+    so one build can drive both RGB and BGR panels
+    @param    freq   Desired SPI clock frequency
+    @param    order  SSD1331_ORDER_RGB or SSD1331_ORDER_BGR
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::begin(uint32_t freq, uint8_t order) {
+  if (order == SSD1331_ORDER_BGR)
+    remapColorBits |= SETREMAP_ORDER_BGR;
+  else
+    remapColorBits &= ~SETREMAP_ORDER_BGR;
+  begin(freq);
 }
 
 /**************************************************************************/
@@ -135,7 +189,9 @@ void Adafruit_SSD1331::begin(uint32_t freq) {
 /**************************************************************************/
 Adafruit_SSD1331::Adafruit_SSD1331(int8_t cs, int8_t dc, int8_t mosi,
                                    int8_t sclk, int8_t rst)
-    : Adafruit_SPITFT(TFTWIDTH, TFTHEIGHT, cs, dc, mosi, sclk, rst, -1) , scroll(false) {}
+    : Adafruit_SPITFT(TFTWIDTH, TFTHEIGHT, cs, dc, mosi, sclk, rst, -1) , scroll(false),
+      remapColorBits(SETREMAP_COLOR_BITS), colorDepth(SSD1331_COLORDEPTH_65K),
+      dither(false), job(), run_x(-1) {}
 
 /**************************************************************************/
 /*!
@@ -146,7 +202,9 @@ Adafruit_SSD1331::Adafruit_SSD1331(int8_t cs, int8_t dc, int8_t mosi,
 */
 /**************************************************************************/
 Adafruit_SSD1331::Adafruit_SSD1331(int8_t cs, int8_t dc, int8_t rst)
-    : Adafruit_SPITFT(TFTWIDTH, TFTHEIGHT, cs, dc, rst) , scroll(false) {}
+    : Adafruit_SPITFT(TFTWIDTH, TFTHEIGHT, cs, dc, rst) , scroll(false),
+      remapColorBits(SETREMAP_COLOR_BITS), colorDepth(SSD1331_COLORDEPTH_65K),
+      dither(false), job(), run_x(-1) {}
 
 /**************************************************************************/
 /*!
@@ -166,7 +224,8 @@ Adafruit_SSD1331::Adafruit_SSD1331(SPIClass *spi, int8_t cs, int8_t dc,
 #else
       Adafruit_SPITFT(TFTWIDTH, TFTHEIGHT, spi, cs, dc, rst)
 #endif
-, scroll(false){}
+, scroll(false), remapColorBits(SETREMAP_COLOR_BITS),
+  colorDepth(SSD1331_COLORDEPTH_65K), dither(false), job(), run_x(-1) {}
 
 /**************************************************************************/
 /*!
@@ -180,20 +239,34 @@ void Adafruit_SSD1331::enableDisplay(boolean enable) {
 
 inline void Adafruit_SSD1331::spiWriteXY(int16_t x, int16_t y)
 {
-  bool swap = rotation & 0x01;
+  bool swap = swapXY();
   spiWrite(swap?y:x);
   spiWrite(swap?x:y);
 }
 
-inline void Adafruit_SSD1331::spiWriteColor(int16_t color)
+inline void Adafruit_SSD1331::spiWriteColor(const SSD1331_HWColor &c)
 {
-  spiWrite((color >> 10) & 0x3E); // red
-  spiWrite((color >> 5) & 0x3F);  // green
-  spiWrite((color << 1) & 0x3E);  // blue
+  spiWrite(c.r);
+  spiWrite(c.g);
+  spiWrite(c.b);
+}
+
+// Converts a color for the drawing engine, reusing the last conversion when
+// the color hasn't changed.
+inline const SSD1331_HWColor &Adafruit_SSD1331::engineColor(uint16_t color)
+{
+  if (color != engineColorKey) {
+    engineColorKey = color;
+    engineColorCache = hwColor(color);
+  }
+  return engineColorCache;
 }
 
 void Adafruit_SSD1331::setRotation(uint8_t r)
 {
+#ifdef SSD1331_FIXED_ROTATION
+  r = SSD1331_FIXED_ROTATION;
+#endif
   rotation = (r & 0x03);
   if (rotation & 1) {
     // rotated 90 or 270 degrees -- swap width and height
@@ -204,8 +277,17 @@ void Adafruit_SSD1331::setRotation(uint8_t r)
     _width = WIDTH;
     _height = HEIGHT;
   }
-  
-  uint8_t remap_bits = SETREMAP_COLOR_BITS;
+
+  sendRemap();
+}
+
+// Sends the setremap command for the current rotation and color format.
+void Adafruit_SSD1331::sendRemap(void)
+{
+  uint8_t remap_bits = remapColorBits;
+#ifdef SSD1331_FIXED_ROTATION
+  remap_bits |= SETREMAP_INIT_ROTATION_BITS;
+#else
   switch (rotation) {
   case 0:
     // normal
@@ -224,11 +306,717 @@ void Adafruit_SSD1331::setRotation(uint8_t r)
     remap_bits |= SETREMAP_ROTATION_3_BITS;
   break;
   }
+#endif
 
+  statBegin(SSD1331_STAT_OTHER);
+  run_x = -1;
   sendCommand(SSD1331_CMD_SETREMAP);   // 0xA0
   sendCommand(remap_bits);
 }
 
+/**************************************************************************/
+/*!
+    @brief  Select the pixel data format used by writePixels() and friends.
+    In 256 color mode every pixel is sent as a single RGB332 byte, which
+    halves the bus traffic for bitmaps and pixel streams at the cost of
+    color resolution. The hardware-accelerated line/rect/fill commands always
+    take full color and aren't affected.
+    @param  depth   SSD1331_COLORDEPTH_65K or SSD1331_COLORDEPTH_256
+    @param  useDither  True to apply a 4x4 ordered dither when packing pixels to
+                       RGB332 (ignored in 65k color mode)
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::setColorDepth(uint8_t depth, bool useDither)
+{
+  colorDepth = (depth == SSD1331_COLORDEPTH_256) ? SSD1331_COLORDEPTH_256
+                                                 : SSD1331_COLORDEPTH_65K;
+  dither = useDither && (colorDepth == SSD1331_COLORDEPTH_256);
+
+  remapColorBits &= ~SETREMAP_FORMAT_MASK;
+  remapColorBits |= (colorDepth == SSD1331_COLORDEPTH_256) ? SETREMAP_FORMAT_256
+                                                           : SETREMAP_FORMAT_65K;
+  sendRemap();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Change the color order of the panel at runtime. The chip swaps
+    the channels itself, so pixel data is sent unchanged and this costs
+    nothing per pixel. Already drawn pixels are not converted.
+    @param  order  SSD1331_ORDER_RGB or SSD1331_ORDER_BGR
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::setColorOrder(uint8_t order)
+{
+  if (order == SSD1331_ORDER_BGR)
+    remapColorBits |= SETREMAP_ORDER_BGR;
+  else
+    remapColorBits &= ~SETREMAP_ORDER_BGR;
+  sendRemap();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the current color order
+    @return SSD1331_ORDER_RGB or SSD1331_ORDER_BGR
+*/
+/**************************************************************************/
+uint8_t Adafruit_SSD1331::getColorOrder(void) const
+{
+  return (remapColorBits & SETREMAP_ORDER_BGR) ? SSD1331_ORDER_BGR
+                                               : SSD1331_ORDER_RGB;
+}
+
+// 4x4 Bayer matrix, the ordered dither threshold for each screen position.
+// Entry t of the usual 0-15 matrix is stored as (2t + 1) * 255 / 32, a
+// fraction of a color level centred in the 16 steps, out of 255.
+const uint8_t Adafruit_SSD1331::bayer4x4[4][4] PROGMEM = {
+  {   7, 135,  39, 167 },
+  { 199,  71, 231, 103 },
+  {  55, 183,  23, 151 },
+  { 247, 119, 215,  87 },
+};
+
+// Packs the next pixel of the current address window to RGB332, applying the
+// dither pattern if enabled.
+inline uint8_t Adafruit_SSD1331::pixel332(uint16_t color)
+{
+  if (!dither)
+    return color332(color);
+
+  uint8_t t = ditherThreshold(win_x + win_col, win_row);
+  if (++win_col >= win_w) {
+    win_col = 0;
+    win_row++;
+  }
+
+  // Widen each channel to 8 bits, so it dithers the same as a 24-bit source
+  uint8_t r = color >> 11;
+  uint8_t g = (color >> 5) & 0x3F;
+  uint8_t b = color & 0x1F;
+  return ditherLevel((r << 3) | (r >> 2), 7, t) << 5 |
+         ditherLevel((g << 2) | (g >> 4), 7, t) << 2 |
+         ditherLevel((b << 3) | (b >> 2), 3, t);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write a single pixel, clipped to the screen. Must be called
+    between startWrite() and endWrite(). A pixel that follows the previous
+    one along a row reuses its address window, so it costs just the color
+    bytes. After sending commands of your own that move the display's RAM
+    pointer, call setAddrWindow() before the next writePixel().
+    @param  x      Horizontal position
+    @param  y      Vertical position
+    @param  color  16-bit 5-6-5 Color to draw with
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::writePixel(int16_t x, int16_t y, uint16_t color)
+{
+  if ((x >= 0) && (x < _width) && (y >= 0) && (y < _height)) {
+    // Carry on in the open window if this pixel is the next one along its
+    // row. Otherwise open one to the end of the row, so the pixels after
+    // it can follow without another window.
+    if (x != run_x || y != run_y) {
+      setAddrWindow(x, y, _width - x, 1);
+      run_y = y;
+    }
+    run_x = x + 1;
+    HookScope hook(this, SSD1331_STAT_PIXELS, 1, 1, colorDepth / 8);
+    statBegin(SSD1331_STAT_PIXELS);
+    if (colorDepth == SSD1331_COLORDEPTH_256)
+      spiWrite(pixel332(color));
+    else
+      SPI_WRITE16(color);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Issue a series of pixels from memory to the display. Must be
+    called between startWrite() and endWrite(), after setAddrWindow().
+    @param  colors     Pointer to array of 16-bit 5-6-5 pixel values
+    @param  len        Number of pixels to write
+    @param  block      If true (default), wait for any DMA transfer to finish
+                       before returning (65k color mode only)
+    @param  bigEndian  If true, colors are big-endian
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::writePixels(uint16_t *colors, uint32_t len, bool block,
+                                   bool bigEndian)
+{
+  HookScope hook(this, SSD1331_STAT_PIXELS, len, 1, len * (colorDepth / 8));
+  statBegin(SSD1331_STAT_PIXELS);
+  if (colorDepth != SSD1331_COLORDEPTH_256) {
+#ifdef SSD1331_BUS_TAP
+    if (tap) {
+      // Skip DMA so the tap sees every byte
+      while (len--) {
+        uint16_t color = *colors++;
+        SPI_WRITE16(bigEndian ? (color >> 8) | (color << 8) : color);
+      }
+      return;
+    }
+#endif
+    statBytes(len * 2, true);
+    Adafruit_SPITFT::writePixels(colors, len, block, bigEndian);
+    return;
+  }
+
+  while (len--) {
+    uint16_t color = *colors++;
+    if (bigEndian)
+      color = (color >> 8) | (color << 8);
+    spiWrite(pixel332(color));
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Issue a series of pixels, all the same color. Must be called
+    between startWrite() and endWrite(), after setAddrWindow().
+    @param  color  16-bit 5-6-5 Color to draw with
+    @param  len    Number of pixels to write
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::writeColor(uint16_t color, uint32_t len)
+{
+  HookScope hook(this, SSD1331_STAT_PIXELS, len, 1, len * (colorDepth / 8));
+  statBegin(SSD1331_STAT_PIXELS);
+  if (colorDepth != SSD1331_COLORDEPTH_256) {
+#ifdef SSD1331_BUS_TAP
+    if (tap) {
+      while (len--)
+        SPI_WRITE16(color);
+      return;
+    }
+#endif
+    statBytes(len * 2, true);
+    Adafruit_SPITFT::writeColor(color, len);
+    return;
+  }
+
+  if (dither) {
+    while (len--)
+      spiWrite(pixel332(color));
+  } else {
+    uint8_t c = color332(color);
+    while (len--)
+      spiWrite(c);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Send one pixel to the current address window, in its own
+    transaction. Call setAddrWindow() first.
+    @param  color  16-bit 5-6-5 Color to draw with
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::pushColor(uint16_t color)
+{
+  startWrite();
+  writeColor(color, 1);
+  endWrite();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Issue a series of pixels already packed to RGB332. Only valid in
+    256 color mode. Must be called between startWrite() and endWrite(),
+    after setAddrWindow().
+    @param  colors  Pointer to array of 8-bit 3-3-2 pixel values
+    @param  len     Number of pixels to write
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::writePixels332(const uint8_t *colors, uint32_t len)
+{
+  HookScope hook(this, SSD1331_STAT_PIXELS, len, 1, len);
+  statBegin(SSD1331_STAT_PIXELS);
+  while (len--)
+    spiWrite(*colors++);
+}
+
+// Waits for the display's drawing engine to finish a fill or copy.
+inline void Adafruit_SSD1331::engineWait(uint16_t us)
+{
+#ifdef SSD1331_INSTRUMENT
+  stats.prim[statPrim].delayUs += us;
+#endif
+  bool wait = true;
+#ifdef SSD1331_BUS_TAP
+  if (tap)
+    tap->busDelay(us);
+  wait = !tapOffline;
+#endif
+#ifdef SSD1331_HOOKS
+  callHook(SSD1331_HOOK_WAIT, hookOp, 0, 0, us);
+#endif
+  if (wait)
+    delayMicroseconds(us);
+#ifdef SSD1331_HOOKS
+  callHook(SSD1331_HOOK_WAIT_END, hookOp, 0, 0, us);
+#endif
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stream a recorded command macro straight to the display. Macros
+    are byte strings in PROGMEM made of chunks, each starting with a header
+    byte: 1 to SSD1331_MACRO_MAXRUN for that many command bytes,
+    SSD1331_MACRO_DATA plus a count for that many data bytes, or
+    SSD1331_MACRO_DELAY followed by a 16-bit little-endian delay in
+    microseconds. SSD1331_MACRO_END ends the macro. See
+    SSD1331_CommandRecorder for a way to make them.
+    @param  macro  Pointer to the macro, in PROGMEM
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::replay(const uint8_t *macro)
+{
+  startWrite();
+  statBegin(SSD1331_STAT_OTHER);
+  run_x = -1;
+  for (;;) {
+    uint8_t header = pgm_read_byte(macro++);
+    if (header == SSD1331_MACRO_END)
+      break;
+    if (header == SSD1331_MACRO_DELAY) {
+      uint16_t us = pgm_read_byte(macro) | (pgm_read_byte(macro + 1) << 8);
+      macro += 2;
+      engineWait(us);
+      continue;
+    }
+
+    uint8_t count = header & ~SSD1331_MACRO_DATA;
+    if (header & SSD1331_MACRO_DATA)
+      SPI_DC_HIGH();
+    else
+      SPI_DC_LOW();
+    while (count--)
+      spiWrite(pgm_read_byte(macro++));
+  }
+  SPI_DC_HIGH();
+  endWrite();
+}
+
+#ifdef SSD1331_BUS_TAP
+/**************************************************************************/
+/*!
+    @brief  Pass a copy of every byte sent to the display to a tap.
+    @param  t        The tap, or NULL to remove it
+    @param  offline  If true, bytes only go to the tap and nothing is sent to
+                     the display (and no time is spent waiting for it): no
+                     SPI transactions are opened and CS and D/C are left
+                     alone. Don't change it between startWrite() and
+                     endWrite().
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::setBusTap(SSD1331_BusTap *t, bool offline)
+{
+  offline = t && offline;
+  // A pixel run's window was only opened on whatever received the bytes,
+  // so it can't be carried over to a different receiver
+  if (offline != tapOffline || (offline && t != tap))
+    run_x = -1;
+  tap = t;
+  tapOffline = offline;
+}
+#endif
+
+#ifdef SSD1331_INSTRUMENT
+/**************************************************************************/
+/*!
+    @brief  Zero the bus counters
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::resetStats(void)
+{
+  memset(&stats, 0, sizeof(stats));
+}
+
+/**************************************************************************/
+/*!
+    @brief   Print the bus counters as a table, one primitive per line, for
+    streaming from the field
+    @param   p  Where to print them, e.g. Serial
+    @return  Number of bytes printed
+*/
+/**************************************************************************/
+size_t Adafruit_SSD1331::printStats(Print &p) const
+{
+  static const char names[SSD1331_STAT_COUNT][7] = {
+      "fill", "clear", "line", "rect", "copy", "window", "pixels", "other"};
+  size_t n = p.println(F("prim\tcalls\tcmd\tdata\tdc\ttrans\tdelay_us"));
+  for (uint8_t i = 0; i < SSD1331_STAT_COUNT; i++) {
+    const SSD1331_PrimitiveStats &s = stats.prim[i];
+    n += p.print(names[i]);
+    n += p.print('\t');
+    n += p.print(s.calls);
+    n += p.print('\t');
+    n += p.print(s.commandBytes);
+    n += p.print('\t');
+    n += p.print(s.dataBytes);
+    n += p.print('\t');
+    n += p.print(s.dcToggles);
+    n += p.print('\t');
+    n += p.print(s.transactions);
+    n += p.print('\t');
+    n += p.println(s.delayUs);
+  }
+  return n;
+}
+#endif
+
+#ifdef SSD1331_SHADOW_SPI
+/**************************************************************************/
+/*!
+    @brief  Begin an SPI transaction, letting the tap and the counters know
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::startWrite(void)
+{
+#ifdef SSD1331_INSTRUMENT
+  newTransaction = true;
+#endif
+#ifdef SSD1331_BUS_TAP
+  if (tap)
+    tap->busBegin();
+  if (tapOffline)
+    return;
+#endif
+  Adafruit_SPITFT::startWrite();
+}
+
+/**************************************************************************/
+/*!
+    @brief  End an SPI transaction, letting the tap know
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::endWrite(void)
+{
+#ifdef SSD1331_BUS_TAP
+  if (tap)
+    tap->busEnd();
+  if (tapOffline)
+    return;
+#endif
+  Adafruit_SPITFT::endWrite();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write a single byte to the display, counting it and passing it
+    to the tap
+    @param  b  The byte
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::spiWrite(uint8_t b)
+{
+  statBytes(1, dcData);
+#ifdef SSD1331_BUS_TAP
+  if (tap)
+    tap->busWrite(b, dcData);
+  if (tapOffline)
+    return;
+#endif
+  Adafruit_SPITFT::spiWrite(b);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write a 16-bit value to the display, MSB first, counting it and
+    passing it to the tap
+    @param  w  The value
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::SPI_WRITE16(uint16_t w)
+{
+  spiWrite(w >> 8);
+  spiWrite(w);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Send a command byte, optionally followed by data bytes
+    @param  commandByte   The command
+    @param  dataBytes     Data to send with D/C high, or NULL
+    @param  numDataBytes  Number of data bytes
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::sendCommand(uint8_t commandByte, uint8_t *dataBytes,
+                                   uint8_t numDataBytes)
+{
+  sendCommand(commandByte, (const uint8_t *)dataBytes, numDataBytes);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Send a command byte, optionally followed by data bytes
+    @param  commandByte   The command
+    @param  dataBytes     Data to send with D/C high, or NULL
+    @param  numDataBytes  Number of data bytes
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::sendCommand(uint8_t commandByte,
+                                   const uint8_t *dataBytes,
+                                   uint8_t numDataBytes)
+{
+  startWrite();
+  statBegin(SSD1331_STAT_OTHER);
+  SPI_DC_LOW();
+  spiWrite(commandByte);
+  SPI_DC_HIGH();
+  while (numDataBytes--)
+    spiWrite(*dataBytes++);
+  endWrite();
+}
+#endif
+
+// Clips a bitmap to the screen. On return (x, y, w, h) is the visible area
+// and (bx, by) its top left corner within the bitmap. Returns false if
+// nothing is visible.
+bool Adafruit_SSD1331::clipRect(int16_t &x, int16_t &y, int16_t &w,
+                                int16_t &h)
+{
+  if ((x >= _width) || (y >= _height) || (x + w <= 0) || (y + h <= 0) ||
+      (w <= 0) || (h <= 0))
+    return false;
+
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  if (x + w > _width)
+    w = _width - x;
+  if (y + h > _height)
+    h = _height - y;
+  return true;
+}
+
+// Clips a bitmap like clipRect(), also giving the offset of its first
+// visible pixel.
+bool Adafruit_SSD1331::clipBitmap(int16_t &x, int16_t &y, int16_t &w,
+                                  int16_t &h, int16_t &bx, int16_t &by)
+{
+  int16_t x0 = x, y0 = y;
+  if (!clipRect(x, y, w, h))
+    return false;
+  bx = x - x0;
+  by = y - y0;
+  return true;
+}
+
+// Sends pixels from RAM or PROGMEM into the current address window. Flash
+// is copied to a small buffer a chunk at a time, so it still goes out in
+// bulk (and by DMA where supported).
+void Adafruit_SSD1331::writeBitmapRow(const uint16_t *pixels, int16_t len,
+                                      bool progmem)
+{
+  if (!progmem) {
+    writePixels((uint16_t *)pixels, len);
+    return;
+  }
+  uint16_t chunk[32];
+  for (int16_t i = 0; i < len; i += 32) {
+    uint8_t n = min(len - i, 32);
+    for (uint8_t j = 0; j < n; j++)
+      chunk[j] = pgm_read_word(&pixels[i + j]);
+    writePixels(chunk, n);
+  }
+}
+
+static inline bool maskBit(const uint8_t *mask, int16_t i, bool progmem)
+{
+  uint8_t b = progmem ? pgm_read_byte(&mask[i >> 3]) : mask[i >> 3];
+  return b & (0x80 >> (i & 7));
+}
+
+// Draws a clipped bitmap. Without a mask the whole area goes through one
+// address window; with one, each row is split into runs of opaque pixels,
+// one window per run.
+void Adafruit_SSD1331::drawBitmap16(int16_t x, int16_t y,
+                                    const uint16_t *bitmap,
+                                    const uint8_t *mask, int16_t w, int16_t h,
+                                    bool progmem)
+{
+  int16_t stride = w, bx, by;
+  if (!clipBitmap(x, y, w, h, bx, by))
+    return;
+  bitmap += (int32_t)by * stride + bx;
+
+  startWrite();
+  if (!mask) {
+    setAddrWindow(x, y, w, h);
+    for (; h--; bitmap += stride)
+      writeBitmapRow(bitmap, w, progmem);
+    endWrite();
+    return;
+  }
+
+  int16_t maskStride = (stride + 7) / 8; // Mask rows are byte-aligned
+  mask += (int32_t)by * maskStride;
+  for (; h--; y++, bitmap += stride, mask += maskStride) {
+    int16_t i = 0;
+    while (i < w) {
+      while (i < w && !maskBit(mask, bx + i, progmem))
+        i++;
+      int16_t start = i;
+      while (i < w && maskBit(mask, bx + i, progmem))
+        i++;
+      if (i > start) {
+        setAddrWindow(x + start, y, i - start, 1);
+        writeBitmapRow(bitmap + start, i - start, progmem);
+      }
+    }
+  }
+  endWrite();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Draw a 16-bit image (565 RGB) from PROGMEM, clipped to the
+    screen, through a single address window.
+    @param  x       Top left corner x coordinate
+    @param  y       Top left corner y coordinate
+    @param  bitmap  Pointer to 16-bit array of pixel values, in PROGMEM
+    @param  w       Width of bitmap in pixels
+    @param  h       Height of bitmap in pixels
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::drawRGBBitmap(int16_t x, int16_t y,
+                                     const uint16_t bitmap[], int16_t w,
+                                     int16_t h)
+{
+  drawBitmap16(x, y, bitmap, NULL, w, h, true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Draw a 16-bit image (565 RGB) from PROGMEM with a 1-bit mask
+    (set bits are opaque), clipped to the screen. Each row is sent as runs
+    of opaque pixels.
+    @param  x       Top left corner x coordinate
+    @param  y       Top left corner y coordinate
+    @param  bitmap  Pointer to 16-bit array of pixel values, in PROGMEM
+    @param  mask    Pointer to 1-bit mask, rows padded to whole bytes, in
+                    PROGMEM
+    @param  w       Width of bitmap in pixels
+    @param  h       Height of bitmap in pixels
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::drawRGBBitmap(int16_t x, int16_t y,
+                                     const uint16_t bitmap[],
+                                     const uint8_t mask[], int16_t w,
+                                     int16_t h)
+{
+  drawBitmap16(x, y, bitmap, mask, w, h, true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Draw a 16-bit image (565 RGB) from RAM, clipped to the screen,
+    through a single address window.
+    @param  x       Top left corner x coordinate
+    @param  y       Top left corner y coordinate
+    @param  bitmap  Pointer to 16-bit array of pixel values
+    @param  w       Width of bitmap in pixels
+    @param  h       Height of bitmap in pixels
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap,
+                                     int16_t w, int16_t h)
+{
+  drawBitmap16(x, y, bitmap, NULL, w, h, false);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Draw a 16-bit image (565 RGB) from RAM with a 1-bit mask (set
+    bits are opaque), clipped to the screen. Each row is sent as runs of
+    opaque pixels.
+    @param  x       Top left corner x coordinate
+    @param  y       Top left corner y coordinate
+    @param  bitmap  Pointer to 16-bit array of pixel values
+    @param  mask    Pointer to 1-bit mask, rows padded to whole bytes
+    @param  w       Width of bitmap in pixels
+    @param  h       Height of bitmap in pixels
+*/
+/**************************************************************************/
+void Adafruit_SSD1331::drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap,
+                                     uint8_t *mask, int16_t w, int16_t h)
+{
+  drawBitmap16(x, y, bitmap, mask, w, h, false);
+}
+
+/**************************************************************************/
+/*!
+    @brief   Queue a 16-bit image to be drawn a slice at a time by service(),
+    so a large bitmap doesn't hold up loop(). Replaces any bitmap still
+    queued.
+    @param   x        Top left corner x coordinate
+    @param   y        Top left corner y coordinate
+    @param   bitmap   16-bit 5-6-5 image, which must stay valid until the
+                      drawing is finished
+    @param   w        Width of the image in pixels
+    @param   h        Height of the image in pixels
+    @param   progmem  True if the image is in PROGMEM, false for RAM
+    @return  True if anything is left to draw after clipping
+*/
+/**************************************************************************/
+bool Adafruit_SSD1331::queueRGBBitmap(int16_t x, int16_t y,
+                                      const uint16_t *bitmap, int16_t w,
+                                      int16_t h, bool progmem)
+{
+  job.bitmap = NULL;
+  int16_t bx, by;
+  job.stride = w;
+  if (!clipBitmap(x, y, w, h, bx, by))
+    return false;
+
+  job.x = x;
+  job.y = y;
+  job.w = w;
+  job.h = h;
+  job.progmem = progmem;
+  job.bitmap = bitmap + (int32_t)by * job.stride + bx;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Draw rows of the queued bitmap for at most about maxUs
+    microseconds, then return. Call from loop() or an idle task until it
+    returns false. Drawing is done a row at a time, so a slice can overrun
+    by up to one row; other drawing may happen between calls.
+    @param   maxUs  Time slice in microseconds
+    @return  True if there is still work pending
+*/
+/**************************************************************************/
+bool Adafruit_SSD1331::service(uint32_t maxUs)
+{
+  if (!job.bitmap)
+    return false;
+
+  uint32_t start = micros();
+  startWrite();
+  // Other drawing may have moved the window since the last slice
+  setAddrWindow(job.x, job.y, job.w, job.h);
+  do {
+    writeBitmapRow(job.bitmap, job.w, job.progmem);
+    job.bitmap += job.stride;
+    job.y++;
+  } while (--job.h && (uint32_t)(micros() - start) < maxUs);
+  endWrite();
+
+  if (!job.h)
+    job.bitmap = NULL;
+  return job.bitmap != NULL;
+}
+
 /**************************************************************************/
 /*!
     @brief      Invert the display (ideally using built-in hardware command)
@@ -252,28 +1040,17 @@ void Adafruit_SSD1331::invertDisplay(bool i) {
 /**************************************************************************/
 void Adafruit_SSD1331::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
                                  uint16_t color) {
+  if (!clipRect(x, y, w, h))
+    return;
   int16_t x1 = x + w;
   int16_t y1 = y + h;
 
-  // Bail out if completely off-screen
-  if (x1 < 0 || x >= _width || y1 < 0 || y >= _height) {
-    return;
-  }
-
-  if (x < 0)
-    x = 0;
-  if (x1 > _width)
-    x1 = _width;
-  if (y < 0)
-    y = 0;
-  if (y1 > _height)
-    y1 = _height;
-  
-  // Bail out if clipped rect is empty
-  if (x1 - 1 < x || y1 - 1 < y) {
-    return;
-  }
-
+  HookScope hook(this, color ? SSD1331_STAT_FILL : SSD1331_STAT_CLEAR, w, h,
+                 !color               ? SSD1331_BYTES_CLEAR
+                 : (w == 1 || h == 1) ? SSD1331_BYTES_LINE
+                                      : SSD1331_BYTES_RECT);
+  statBegin(color ? SSD1331_STAT_FILL : SSD1331_STAT_CLEAR);
+  run_x = -1; // The drawing engine may move the RAM pointer
   SPI_DC_LOW();  // enter command mode
 
   if (color == 0)
@@ -283,10 +1060,13 @@ void Adafruit_SSD1331::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
     spiWriteXY(x, y); // starting column/row
     spiWriteXY(x1 - 1, y1 - 1); // finishing column/row
   }
-  else if (x == x1 || y == y1)
+  else if (w == 1 || h == 1)
   {
     // If the rect is 1 pixel wide or high, we can use the less expensive line-drawing command (writes 8 bytes over SPI)
-    writeLine(x, y, x1, y1, color);
+    spiWrite(SSD1331_CMD_DRAWLINE);
+    spiWriteXY(x, y); // starting column/row
+    spiWriteXY(x1 - 1, y1 - 1); // finishing column/row
+    spiWriteColor(engineColor(color));
   }
   else
   {
@@ -296,8 +1076,9 @@ void Adafruit_SSD1331::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
     spiWrite(SSD1331_CMD_DRAWRECT); // enter "draw rectangle" mode
     spiWriteXY(x, y); // starting column/row
     spiWriteXY(x1 - 1, y1 - 1); // finishing column/row
-    spiWriteColor(color);
-    spiWriteColor(color);
+    const SSD1331_HWColor &c = engineColor(color);
+    spiWriteColor(c); // outline
+    spiWriteColor(c); // fill
   }
 
   SPI_DC_HIGH(); // exit command mode
@@ -308,19 +1089,30 @@ void Adafruit_SSD1331::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
   // For a full-screen fill, we want to delay somewhere above 1000us. 
   // A full-screen fill is 96 * 64 = 6144 pixels.
   // Dividing this by 4 gives us 1536us, which is close enough.
-  int delay = (w * h) >> 2;
-  delayMicroseconds(delay);
+  engineWait(engineDelay(x1 - x, y1 - y));
 }
 
 void Adafruit_SSD1331::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
 {
-  // writeLine() is the fastest way to do this.
-  writeLine(x, y, x, y + h, color);
+  if (h < 0) {
+    y += h + 1;
+    h = -h;
+  }
+  int16_t w = 1;
+  // The line-drawing command is the fastest way to do this.
+  if (clipRect(x, y, w, h))
+    engineLine(x, y, x, y + h - 1, color);
 }
 void Adafruit_SSD1331::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
 {
-  // writeLine() is the fastest way to do this.
-  writeLine(x, y, x + w, y, color);
+  if (w < 0) {
+    x += w + 1;
+    w = -w;
+  }
+  int16_t h = 1;
+  // The line-drawing command is the fastest way to do this.
+  if (clipRect(x, y, w, h))
+    engineLine(x, y, x + w - 1, y, color);
 }
 
 /**************************************************************************/
@@ -335,21 +1127,33 @@ void Adafruit_SSD1331::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t
 /**************************************************************************/
 void Adafruit_SSD1331::writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
                             uint16_t color) {
-
-  // Simple, dumb clip. If either point is outside the screen, don't draw.
-  if (x0 < 0 || x0 >= _width || 
-      x1 < 0 || x1 >= _width || 
-      y0 < 0 || y0 >= _height || 
-      y1 < 0 || y1 >= _height) {
-    return;
+  if (x0 >= 0 && x0 < _width && x1 >= 0 && x1 < _width &&
+      y0 >= 0 && y0 < _height && y1 >= 0 && y1 < _height) {
+    engineLine(x0, y0, x1, y1, color);
+  } else if (y0 == y1) {
+    writeFastHLine(min(x0, x1), y0, abs(x1 - x0) + 1, color);
+  } else if (x0 == x1) {
+    writeFastVLine(x0, min(y0, y1), abs(y1 - y0) + 1, color);
+  } else {
+    // Moving the end points of a diagonal line onto the screen would shift
+    // its pixels, so draw it pixel by pixel; off-screen ones are skipped.
+    Adafruit_GFX::writeLine(x0, y0, x1, y1, color);
   }
+}
 
+// Draws a line that is entirely on screen with the drawing engine.
+void Adafruit_SSD1331::engineLine(int16_t x0, int16_t y0, int16_t x1,
+                                  int16_t y1, uint16_t color) {
+  HookScope hook(this, SSD1331_STAT_LINE, abs(x1 - x0) + 1, abs(y1 - y0) + 1,
+                 SSD1331_BYTES_LINE);
+  statBegin(SSD1331_STAT_LINE);
+  run_x = -1; // The drawing engine may move the RAM pointer
   SPI_DC_LOW();  // enter command mode
 
   spiWrite(SSD1331_CMD_DRAWLINE); // enter "draw rectangle" mode
   spiWriteXY(x0, y0); // starting column/row
   spiWriteXY(x1, y1); // finishing column/row
-  spiWriteColor(color);
+  spiWriteColor(engineColor(color));
 
   SPI_DC_HIGH(); // exit command mode
 }
@@ -451,21 +1255,27 @@ void Adafruit_SSD1331::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
 /**************************************************************************/
 void Adafruit_SSD1331::drawRect(int16_t x, int16_t y, int16_t w, int16_t h,
                             uint16_t color) {
-  if (x < 0 || x >= _width || 
-      y < 0 || y >= _height ||
-      w <= 0 || h <= 0)
+  if (w <= 0 || h <= 0)
     return;
 
   int16_t x1 = x + w;
   int16_t y1 = y + h;
 
-  if (x1 > _width)
-    x1 = _width;
-  if (y1 >= _height)
-    y1 = _height;
-
   startWrite();
 
+  if (x < 0 || y < 0 || x1 > _width || y1 > _height) {
+    // Partly off screen: only the edges that show, clipped
+    writeFastHLine(x, y, w, color);
+    writeFastHLine(x, y1 - 1, w, color);
+    writeFastVLine(x, y, h, color);
+    writeFastVLine(x1 - 1, y, h, color);
+    endWrite();
+    return;
+  }
+
+  HookScope hook(this, SSD1331_STAT_RECT, w, h, SSD1331_BYTES_RECT);
+  statBegin(SSD1331_STAT_RECT);
+  run_x = -1; // The drawing engine may move the RAM pointer
   SPI_DC_LOW();  // enter command mode
   
   spiWrite(SSD1331_CMD_FILL); // disble fill
@@ -473,8 +1283,9 @@ void Adafruit_SSD1331::drawRect(int16_t x, int16_t y, int16_t w, int16_t h,
   spiWrite(SSD1331_CMD_DRAWRECT); // enter "draw rectangle" mode
   spiWriteXY(x, y); // starting column/row
   spiWriteXY(x1 - 1, y1 - 1); // finishing column/row
-  spiWriteColor(color);
-  spiWriteColor(color);
+  const SSD1331_HWColor &c = engineColor(color);
+  spiWriteColor(c); // outline
+  spiWriteColor(c); // fill (unused, fill is off)
 
   SPI_DC_HIGH(); // exit command mode
 
@@ -523,6 +1334,9 @@ void Adafruit_SSD1331::copyBits(int16_t x, int16_t y, int16_t w, int16_t h,
 
   startWrite();
 
+  HookScope hook(this, SSD1331_STAT_COPY, w, h, SSD1331_BYTES_COPY);
+  statBegin(SSD1331_STAT_COPY);
+  run_x = -1; // The drawing engine may move the RAM pointer
   SPI_DC_LOW();  // enter command mode
   
   spiWrite(SSD1331_CMD_FILL); // configure invert
@@ -542,8 +1356,7 @@ void Adafruit_SSD1331::copyBits(int16_t x, int16_t y, int16_t w, int16_t h,
   // For a full-screen blit, we want to delay somewhere above 1000us. 
   // A full-screen blit is 96 * 64 = 6144 pixels.
   // Dividing this by 4 gives us 1536us, which is close enough.
-  int delay = (w * h) >> 2;
-  delayMicroseconds(delay);
+  engineWait(engineDelay(w, h));
 }
 
 size_t Adafruit_SSD1331::write(uint8_t c) {
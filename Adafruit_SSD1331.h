@@ -2,6 +2,9 @@
  * @file Adafruit_SSD1331.h
  */
 
+#ifndef _ADAFRUIT_SSD1331_H_
+#define _ADAFRUIT_SSD1331_H_
+
 #include "Arduino.h"
 #include <Adafruit_GFX.h>
 #include <Adafruit_SPITFT.h>
@@ -11,8 +14,26 @@
 // Enable copyBits and setTextScroll 
 #define SSD1331_EXTRAS
 
+// Uncomment to pass every byte sent to the display through an optional
+// SSD1331_BusTap (needed to record command macros). Costs a check per byte.
+// #define SSD1331_BUS_TAP
+
+// Uncomment to count calls, bytes, D/C toggles, transactions and engine
+// waits per primitive, see getStats(). Costs a few counter updates per byte.
+// #define SSD1331_INSTRUMENT
+
+// Uncomment to call a hook on entry to and exit from each primitive, and
+// around waits for the drawing engine, for external profilers. See
+// setHook(). Costs one indirect call per primitive.
+// #define SSD1331_HOOKS
+
+#if defined(SSD1331_BUS_TAP) || defined(SSD1331_INSTRUMENT)
+#define SSD1331_SHADOW_SPI //!< The driver shadows SPITFT's low-level bus calls
+#endif
+
 /*!
- * @brief Select one of these defines to set the pixel color order
+ * @brief Select one of these defines to set the default pixel color order,
+ * which begin(freq, order) or setColorOrder() can change at runtime
  */
 #define SSD1331_COLORORDER_RGB
 // #define SSD1331_COLORORDER_BGR
@@ -21,10 +42,47 @@
 #error "RGB and BGR can not both be defined for SSD1331_COLORODER."
 #endif
 
+// Uncomment and set to 0-3 for products that never rotate. Coordinates are
+// then sent without checking the rotation, begin() sets this rotation up,
+// and setRotation() ignores any other value. This applies to every
+// Adafruit_SSD1331 in the build: a sketch can't have one fixed display and
+// one that rotates at runtime, so leave it off for such a sketch.
+// #define SSD1331_FIXED_ROTATION 0
+
+#if defined(SSD1331_FIXED_ROTATION) &&                                       \
+    (SSD1331_FIXED_ROTATION < 0 || SSD1331_FIXED_ROTATION > 3)
+#error "SSD1331_FIXED_ROTATION must be 0, 1, 2 or 3."
+#endif
+
+/*!
+ * @brief Pixel data formats, for use with setColorDepth()
+ */
+#define SSD1331_COLORDEPTH_65K 16 //!< 65k color, 2 bytes per pixel (default)
+#define SSD1331_COLORDEPTH_256 8  //!< 256 color, RGB332, 1 byte per pixel
+
+/*!
+ * @brief Panel color orders, for use with setColorOrder()
+ */
+#define SSD1331_ORDER_RGB 0 //!< Red in the first subpixel
+#define SSD1331_ORDER_BGR 1 //!< Blue in the first subpixel
+
+// Chunk headers in a recorded command macro, see replay()
+#define SSD1331_MACRO_END 0x00   //!< End of macro
+#define SSD1331_MACRO_DELAY 0x7F //!< Followed by a 16-bit LE delay in us
+#define SSD1331_MACRO_DATA 0x80  //!< OR'd with a count of data bytes
+#define SSD1331_MACRO_MAXRUN 0x7E //!< Most bytes in a single chunk
+
 // Timing Delays
 #define SSD1331_DELAYS_HWFILL (3) //!< Fill delay
 #define SSD1331_DELAYS_HWLINE (1) //!< Line delay
 
+// Bytes sent over SPI by each accelerated primitive
+#define SSD1331_BYTES_CLEAR 5   //!< writeFillRect() in black
+#define SSD1331_BYTES_LINE 8    //!< writeLine(), and 1-pixel wide rects
+#define SSD1331_BYTES_RECT 13   //!< writeFillRect() and drawRect()
+#define SSD1331_BYTES_COPY 9    //!< copyBits()
+#define SSD1331_BYTES_WINDOW 6  //!< setAddrWindow()
+
 // SSD1331 Commands
 #define SSD1331_CMD_DRAWLINE 0x21      //!< Draw line
 #define SSD1331_CMD_DRAWRECT 0x22      //!< Draw rectangle
@@ -58,6 +116,95 @@
 #define SSD1331_CMD_PRECHARGELEVEL 0xBB //!< Set pre-charge voltage
 #define SSD1331_CMD_VCOMH 0xBE          //!< Set Vcomh voltge
 
+#ifdef SSD1331_BUS_TAP
+/// Receives a copy of every byte the driver sends to the display
+class SSD1331_BusTap {
+public:
+  virtual ~SSD1331_BusTap() {}
+  /*!
+    @brief  Called for every byte sent
+    @param  b     The byte
+    @param  data  True if sent with D/C high (data), false for a command
+  */
+  virtual void busWrite(uint8_t b, bool data) = 0;
+  /*!
+    @brief  Called when the driver waits for the display's drawing engine
+    @param  us  Delay in microseconds
+  */
+  virtual void busDelay(uint16_t us) { (void)us; }
+  /*!
+    @brief  Called when the driver starts an SPI transaction
+  */
+  virtual void busBegin(void) {}
+  /*!
+    @brief  Called when the driver ends an SPI transaction
+  */
+  virtual void busEnd(void) {}
+};
+#endif
+
+/// Primitive types counted separately by SSD1331_INSTRUMENT
+enum {
+  SSD1331_STAT_FILL,   ///< Accelerated filled rectangles
+  SSD1331_STAT_CLEAR,  ///< Accelerated clears (fills with black)
+  SSD1331_STAT_LINE,   ///< Accelerated lines
+  SSD1331_STAT_RECT,   ///< Accelerated rectangle outlines
+  SSD1331_STAT_COPY,   ///< Accelerated copies
+  SSD1331_STAT_WINDOW, ///< Address windows for pixel data
+  SSD1331_STAT_PIXELS, ///< Pixel data
+  SSD1331_STAT_OTHER,  ///< Everything else: setup, remap, macros...
+  SSD1331_STAT_COUNT   ///< Number of primitive types
+};
+
+/// Bus counters for one primitive type
+struct SSD1331_PrimitiveStats {
+  uint32_t calls;        ///< Times the primitive was used
+  uint32_t commandBytes; ///< Bytes sent with D/C low
+  uint32_t dataBytes;    ///< Bytes sent with D/C high
+  uint32_t dcToggles;    ///< Changes of the D/C line
+  uint32_t transactions; ///< SPI transactions started
+  uint32_t delayUs;      ///< Time spent waiting for the drawing engine
+};
+
+/// Bus counters for every primitive type, see Adafruit_SSD1331::getStats()
+struct SSD1331_Stats {
+  SSD1331_PrimitiveStats prim[SSD1331_STAT_COUNT]; ///< By SSD1331_STAT_*
+};
+
+/// A color in the drawing engine's command format, see hwColor()
+struct SSD1331_HWColor {
+  uint8_t r; ///< Red, 6 bits (the 5 bits of RGB565 shifted up)
+  uint8_t g; ///< Green, 6 bits
+  uint8_t b; ///< Blue, 6 bits (the 5 bits of RGB565 shifted up)
+};
+
+#ifdef SSD1331_HOOKS
+/*!
+ * @brief Events passed to a hook
+ */
+enum {
+  SSD1331_HOOK_BEGIN,     ///< A primitive starts
+  SSD1331_HOOK_END,       ///< The primitive is done
+  SSD1331_HOOK_WAIT,      ///< The driver starts waiting for the engine
+  SSD1331_HOOK_WAIT_END   ///< The wait is over
+};
+
+/*!
+  @brief  Profiling hook
+  @param  event  SSD1331_HOOK_*
+  @param  op     The primitive, SSD1331_STAT_*
+  @param  w      Width of the area it draws, in pixels (0 for waits)
+  @param  h      Height of the area it draws, in pixels (0 for waits)
+  @param  n      Bytes it sends, or microseconds for waits
+*/
+typedef void (*SSD1331_HookFunc)(uint8_t event, uint8_t op, int16_t w,
+                                 int16_t h, uint32_t n);
+
+/// Define this in a sketch to hook every display without calling setHook()
+void ssd1331Hook(uint8_t event, uint8_t op, int16_t w, int16_t h, uint32_t n)
+    __attribute__((weak));
+#endif
+
 /// Class to manage hardware interface with SSD1331 chipset
 class Adafruit_SSD1331 : public Adafruit_SPITFT {
 public:
@@ -68,6 +215,7 @@ public:
 
   // commands
   void begin(uint32_t begin = 8000000);
+  void begin(uint32_t freq, uint8_t order);
 
   void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
 
@@ -76,6 +224,18 @@ public:
   static const int16_t TFTWIDTH = 96;  ///< The width of the display
   static const int16_t TFTHEIGHT = 64; ///< The height of the display
 
+  /*!
+    @brief   How long the driver waits for the drawing engine after a fill
+    or copy, so that following commands don't interrupt it. About 1.5ms
+    for the full screen.
+    @param   w  Width of the area in pixels
+    @param   h  Height of the area in pixels
+    @return  Delay in microseconds
+  */
+  static uint16_t engineDelay(int16_t w, int16_t h) {
+    return ((uint32_t)w * h) >> 2;
+  }
+
 #ifdef SSD1331_EXTRAS
   // If this is set to true, the screen will scroll up when text is printed off the bottom.
   void setTextScroll(bool s) { scroll = s; }
@@ -84,6 +244,147 @@ public:
   virtual void setRotation(uint8_t r);
   virtual void invertDisplay(bool i);
 
+  void setColorDepth(uint8_t depth, bool useDither = false);
+  /*!
+    @brief   Get the current pixel data format
+    @return  SSD1331_COLORDEPTH_65K or SSD1331_COLORDEPTH_256
+  */
+  uint8_t getColorDepth(void) const { return colorDepth; }
+
+  void setColorOrder(uint8_t order);
+  uint8_t getColorOrder(void) const;
+
+  /*!
+    @brief   Convert a 16-bit 5-6-5 color to the chip's 8-bit 3-3-2 format.
+    This is three masked shifts rather than a lookup table: a table over
+    every 5-6-5 color would take 64K, and per-channel tables still need
+    the same shifts to index them and to merge the results.
+    @param   color 16-bit 5-6-5 Color
+    @return  8-bit 3-3-2 Color
+  */
+  static uint8_t color332(uint16_t color) {
+    return ((color >> 8) & 0xE0) | ((color >> 6) & 0x1C) | ((color >> 3) & 0x03);
+  }
+
+  /*!
+    @brief   Convert a 16-bit 5-6-5 color to the 3 bytes the line and rect
+    commands take
+    @param   color 16-bit 5-6-5 Color
+    @return  The color in command format
+  */
+  static SSD1331_HWColor hwColor(uint16_t color) {
+    SSD1331_HWColor c = {(uint8_t)((color >> 10) & 0x3E),
+                         (uint8_t)((color >> 5) & 0x3F),
+                         (uint8_t)((color << 1) & 0x3E)};
+    return c;
+  }
+
+  /*!
+    @brief   Get the ordered dither threshold for a screen position. Packing
+    to RGB332 (see setColorDepth()) and Adafruit_SSD1331_Dither both use it,
+    so they give the same pattern.
+    @param   x  Horizontal position
+    @param   y  Vertical position
+    @return  Threshold, a fraction of a color level out of 255
+  */
+  static uint8_t ditherThreshold(int16_t x, int16_t y) {
+    return pgm_read_byte(&bayer4x4[y & 3][x & 3]);
+  }
+  /*!
+    @brief   Reduce an 8-bit channel to fewer levels with ordered dithering
+    @param   v       Channel value, 0-255
+    @param   levels  Highest level kept, e.g. 7 for 3 bits
+    @param   t       Threshold from ditherThreshold()
+    @return  Level, 0 to levels
+  */
+  static uint8_t ditherLevel(uint8_t v, uint8_t levels, uint8_t t) {
+    // s / 255, done as (s + 1 + (s >> 8)) >> 8, which is exact here
+    uint16_t s = (uint16_t)v * levels + t;
+    return (s + 1 + (s >> 8)) >> 8;
+  }
+
+  // Pixel streaming paths. These are overridden (or hidden, where the base
+  // class doesn't make them virtual) so they can pack pixels to RGB332 when
+  // the display is in 256 color mode.
+  virtual void writePixel(int16_t x, int16_t y, uint16_t color);
+  void writePixels(uint16_t *colors, uint32_t len, bool block = true,
+                   bool bigEndian = false);
+  void writeColor(uint16_t color, uint32_t len);
+  void pushColor(uint16_t color);
+  void writePixels332(const uint8_t *colors, uint32_t len);
+  void drawRGBBitmap(int16_t x, int16_t y, const uint16_t bitmap[], int16_t w,
+                     int16_t h);
+  void drawRGBBitmap(int16_t x, int16_t y, const uint16_t bitmap[],
+                     const uint8_t mask[], int16_t w, int16_t h);
+  void drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w,
+                     int16_t h);
+  void drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, uint8_t *mask,
+                     int16_t w, int16_t h);
+
+  void replay(const uint8_t *macro);
+
+  bool queueRGBBitmap(int16_t x, int16_t y, const uint16_t *bitmap, int16_t w,
+                      int16_t h, bool progmem = true);
+  bool service(uint32_t maxUs);
+  /*!
+    @brief   Check whether a queued bitmap is still being drawn
+    @return  True if service() has work left
+  */
+  bool busy(void) const { return job.bitmap != NULL; }
+  /*!
+    @brief  Drop the rest of a queued bitmap
+  */
+  void cancel(void) { job.bitmap = NULL; }
+
+#ifdef SSD1331_BUS_TAP
+  void setBusTap(SSD1331_BusTap *t, bool offline = false);
+#endif
+
+#ifdef SSD1331_HOOKS
+  /*!
+    @brief  Set the profiling hook, replacing ssd1331Hook() if the sketch
+    defines it
+    @param  f  The hook, or NULL for none
+  */
+  void setHook(SSD1331_HookFunc f) { hookFunc = f; }
+#endif
+
+#ifdef SSD1331_INSTRUMENT
+  /*!
+    @brief   Get the bus counters
+    @return  Counters since the last resetStats()
+  */
+  const SSD1331_Stats &getStats(void) const { return stats; }
+  /*!
+    @brief  Copy the bus counters, e.g. to diff against a later snapshot
+    @param  out  Where to copy them
+  */
+  void snapshotStats(SSD1331_Stats &out) const { out = stats; }
+  void resetStats(void);
+  size_t printStats(Print &p) const;
+#endif
+
+#ifdef SSD1331_SHADOW_SPI
+  // Low-level bus access, shadowing Adafruit_SPITFT's so that every byte
+  // goes past the tap and the counters.
+  virtual void startWrite(void);
+  virtual void endWrite(void);
+  void spiWrite(uint8_t b);
+  void SPI_WRITE16(uint16_t w);
+  /*!
+    @brief  Set the data/command line HIGH (data mode)
+  */
+  void SPI_DC_HIGH(void) { setDC(true); }
+  /*!
+    @brief  Set the data/command line LOW (command mode)
+  */
+  void SPI_DC_LOW(void) { setDC(false); }
+  void sendCommand(uint8_t commandByte, uint8_t *dataBytes,
+                   uint8_t numDataBytes);
+  void sendCommand(uint8_t commandByte, const uint8_t *dataBytes = NULL,
+                   uint8_t numDataBytes = 0);
+#endif
+
   virtual void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
                              uint16_t color);
   virtual void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
@@ -115,6 +416,149 @@ protected:
   bool scroll;
 
 private:
+  static const uint8_t bayer4x4[4][4]; // See ditherThreshold()
+
   void spiWriteXY(int16_t x, int16_t y);
-  void spiWriteColor(int16_t color);
+  void spiWriteColor(const SSD1331_HWColor &c);
+  const SSD1331_HWColor &engineColor(uint16_t color);
+  void sendRemap(void);
+  void engineWait(uint16_t us);
+  uint8_t pixel332(uint16_t color);
+  // True if rows and columns are swapped, i.e. rotated 90 or 270 degrees.
+  // A constant with SSD1331_FIXED_ROTATION.
+  bool swapXY(void) const {
+#ifdef SSD1331_FIXED_ROTATION
+    return SSD1331_FIXED_ROTATION & 1;
+#else
+    return rotation & 1;
+#endif
+  }
+
+#ifdef SSD1331_SHADOW_SPI
+  void setDC(bool data) {
+#ifdef SSD1331_INSTRUMENT
+    if (data != dcData)
+      stats.prim[statPrim].dcToggles++;
+#endif
+    dcData = data;
+#ifdef SSD1331_BUS_TAP
+    if (tapOffline)
+      return;
+#endif
+    if (data)
+      Adafruit_SPITFT::SPI_DC_HIGH();
+    else
+      Adafruit_SPITFT::SPI_DC_LOW();
+  }
+#endif
+
+  // Instrumentation hooks, which compile to nothing without
+  // SSD1331_INSTRUMENT. statBegin() counts a call and attributes the bytes
+  // that follow to a primitive, statPhase() only does the latter.
+#ifdef SSD1331_INSTRUMENT
+  void statBegin(uint8_t prim) {
+    statPrim = prim;
+    stats.prim[prim].calls++;
+  }
+  void statPhase(uint8_t prim) { statPrim = prim; }
+  void statBytes(uint32_t n, bool data) {
+    SSD1331_PrimitiveStats &s = stats.prim[statPrim];
+    if (newTransaction) {
+      s.transactions++;
+      newTransaction = false;
+    }
+    if (data)
+      s.dataBytes += n;
+    else
+      s.commandBytes += n;
+  }
+#else
+  void statBegin(uint8_t) {}
+  void statPhase(uint8_t) {}
+  void statBytes(uint32_t, bool) {}
+#endif
+
+  // Calls the profiling hook on entry to a primitive, and again when it
+  // goes out of scope. Compiles to nothing without SSD1331_HOOKS.
+#ifdef SSD1331_HOOKS
+  void callHook(uint8_t event, uint8_t op, int16_t w, int16_t h, uint32_t n) {
+    if (hookFunc)
+      hookFunc(event, op, w, h, n);
+  }
+  class HookScope {
+  public:
+    HookScope(Adafruit_SSD1331 *d, uint8_t op, int16_t w, int16_t h,
+              uint32_t n)
+        : d(d), op(op), w(w), h(h), n(n) {
+      d->hookOp = op;
+      d->callHook(SSD1331_HOOK_BEGIN, op, w, h, n);
+    }
+    ~HookScope() { d->callHook(SSD1331_HOOK_END, op, w, h, n); }
+
+  private:
+    Adafruit_SSD1331 *d;
+    uint8_t op;
+    int16_t w, h;
+    uint32_t n;
+  };
+#else
+  class HookScope {
+  public:
+    HookScope(Adafruit_SSD1331 *, uint8_t, int16_t, int16_t, uint32_t) {}
+  };
+#endif
+
+  bool clipRect(int16_t &x, int16_t &y, int16_t &w, int16_t &h);
+  void engineLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                  uint16_t color);
+  bool clipBitmap(int16_t &x, int16_t &y, int16_t &w, int16_t &h, int16_t &bx,
+                  int16_t &by);
+  void writeBitmapRow(const uint16_t *pixels, int16_t len, bool progmem);
+  void drawBitmap16(int16_t x, int16_t y, const uint16_t *bitmap,
+                    const uint8_t *mask, int16_t w, int16_t h, bool progmem);
+
+  uint8_t remapColorBits; // Color format/order bits of the SETREMAP command
+  uint8_t colorDepth; // SSD1331_COLORDEPTH_65K or SSD1331_COLORDEPTH_256
+  bool dither;        // Ordered dithering when packing to RGB332
+
+  // Bitmap queued by queueRGBBitmap(), already clipped. bitmap points at the
+  // first pixel of the next row to send, NULL when idle.
+  struct {
+    const uint16_t *bitmap;
+    int16_t x, y, w, h; // Remaining area
+    int16_t stride;     // Pixels per bitmap row
+    bool progmem;
+  } job;
+
+  // Current address window, and the position of the next pixel within it.
+  // Only used to place the dither pattern in 256 color mode.
+  int16_t win_x, win_w, win_col, win_row;
+
+  // Where the next pixel goes if writePixel() can carry on in the open
+  // window. run_x is -1 when there isn't one.
+  int16_t run_x, run_y;
+
+  // The last color given to the drawing engine and its command format, so
+  // runs of primitives in one color convert it once
+  uint16_t engineColorKey = 0;
+  SSD1331_HWColor engineColorCache = {0, 0, 0};
+
+#ifdef SSD1331_BUS_TAP
+  SSD1331_BusTap *tap = NULL; // Receives a copy of every byte, if set
+  bool tapOffline = false;    // Send bytes only to the tap, not the display
+#endif
+#ifdef SSD1331_SHADOW_SPI
+  bool dcData = true; // Current state of the D/C line
+#endif
+#ifdef SSD1331_INSTRUMENT
+  SSD1331_Stats stats = {};
+  uint8_t statPrim = SSD1331_STAT_OTHER; // Primitive bytes are counted to
+  bool newTransaction = false; // Count a transaction on the next byte
+#endif
+#ifdef SSD1331_HOOKS
+  SSD1331_HookFunc hookFunc = ssd1331Hook; // NULL unless the sketch has one
+  uint8_t hookOp = SSD1331_STAT_OTHER;     // Primitive a wait belongs to
+#endif
 };
+
+#endif // _ADAFRUIT_SSD1331_H_
@@ -0,0 +1,464 @@
+/*!
+ * @file Adafruit_SSD1331_Canvas.cpp
+ *
+ * Off-screen framebuffers for the SSD1331 driver.
+ *
+ * BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_SSD1331_Canvas.h"
+
+/**************************************************************************/
+/*!
+    @brief  Create an empty tile map for a canvas
+    @param  w  Canvas width in pixels (at most 128)
+    @param  h  Canvas height in pixels (at most 128)
+*/
+/**************************************************************************/
+SSD1331_DirtyTiles::SSD1331_DirtyTiles(uint16_t w, uint16_t h)
+    : cols((w + SSD1331_TILE_SIZE - 1) >> SSD1331_TILE_SHIFT),
+      numRows((h + SSD1331_TILE_SIZE - 1) >> SSD1331_TILE_SHIFT), cursorTy(0),
+      cursorTx(0) {
+  if (cols > SSD1331_MAX_TILE_COLS)
+    cols = SSD1331_MAX_TILE_COLS;
+  if (numRows > SSD1331_MAX_TILE_ROWS)
+    numRows = SSD1331_MAX_TILE_ROWS;
+  clearAll();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Mark every tile touched by a rectangle. The rectangle is clipped
+    to the canvas.
+    @param  x  Top left corner x coordinate
+    @param  y  Top left corner y coordinate
+    @param  w  Width in pixels
+    @param  h  Height in pixels
+*/
+/**************************************************************************/
+void SSD1331_DirtyTiles::mark(int16_t x, int16_t y, int16_t w, int16_t h) {
+  int16_t x1 = x + w - 1;
+  int16_t y1 = y + h - 1;
+  int16_t maxX = (cols << SSD1331_TILE_SHIFT) - 1;
+  int16_t maxY = (numRows << SSD1331_TILE_SHIFT) - 1;
+
+  if (w <= 0 || h <= 0 || x1 < 0 || y1 < 0 || x > maxX || y > maxY)
+    return;
+  if (x < 0)
+    x = 0;
+  if (y < 0)
+    y = 0;
+  if (x1 > maxX)
+    x1 = maxX;
+  if (y1 > maxY)
+    y1 = maxY;
+
+  uint8_t tx0 = x >> SSD1331_TILE_SHIFT;
+  uint8_t tx1 = x1 >> SSD1331_TILE_SHIFT;
+  // Bits tx0..tx1 inclusive
+  uint16_t bits = (uint16_t)((0xFFFFUL << tx0) & (0xFFFFUL >> (15 - tx1)));
+  for (uint8_t ty = y >> SSD1331_TILE_SHIFT; ty <= (y1 >> SSD1331_TILE_SHIFT);
+       ty++) {
+    rows[ty] |= bits;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Mark every tile dirty
+*/
+/**************************************************************************/
+void SSD1331_DirtyTiles::markAll(void) {
+  uint16_t bits = (uint16_t)(0xFFFFUL >> (16 - cols));
+  for (uint8_t ty = 0; ty < numRows; ty++)
+    rows[ty] = bits;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Mark every tile clean
+*/
+/**************************************************************************/
+void SSD1331_DirtyTiles::clearAll(void) { memset(rows, 0, sizeof(rows)); }
+
+/**************************************************************************/
+/*!
+    @brief   Check whether any tile is dirty
+    @return  True if at least one tile is dirty
+*/
+/**************************************************************************/
+bool SSD1331_DirtyTiles::any(void) const {
+  for (uint8_t ty = 0; ty < numRows; ty++) {
+    if (rows[ty])
+      return true;
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Find the next run of adjacent dirty tiles in a tile row and
+    mark it clean. The search carries on from where the last one stopped,
+    wrapping around once, so tiles that keep changing can't starve the rest.
+    @param   ty   Set to the tile row of the run
+    @param   tx0  Set to the first tile column of the run
+    @param   tx1  Set to one past the last tile column of the run
+    @return  False if no tile is dirty
+*/
+/**************************************************************************/
+bool SSD1331_DirtyTiles::takeRun(uint8_t &ty, uint8_t &tx0, uint8_t &tx1) {
+  for (uint8_t rowsLeft = numRows + 1; rowsLeft;) {
+    uint16_t bits = cursorTx < cols ? rows[cursorTy] >> cursorTx : 0;
+    if (!bits) {
+      if (++cursorTy >= numRows)
+        cursorTy = 0;
+      cursorTx = 0;
+      rowsLeft--;
+      continue;
+    }
+
+    while (!(bits & 1)) {
+      bits >>= 1;
+      cursorTx++;
+    }
+    tx0 = cursorTx;
+    uint16_t run = 0;
+    while (cursorTx < cols && (bits & 1)) {
+      run |= 1U << cursorTx;
+      bits >>= 1;
+      cursorTx++;
+    }
+    rows[cursorTy] &= ~run;
+    ty = cursorTy;
+    tx1 = cursorTx;
+    return true;
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate a palette canvas. The buffer is allocated here; check
+    getBuffer() for NULL to see if it succeeded. A 96x64 canvas takes 3KB at
+    4 bits per pixel and 6KB at 8 bits per pixel.
+    @param  bpp  Bits per pixel, 4 (16 colors) or 8 (256 colors)
+    @param  w    Canvas width in pixels (at most 128)
+    @param  h    Canvas height in pixels (at most 128)
+*/
+/**************************************************************************/
+Adafruit_SSD1331_PaletteCanvas::Adafruit_SSD1331_PaletteCanvas(uint8_t bpp,
+                                                               uint16_t w,
+                                                               uint16_t h)
+    : Adafruit_GFX(w, h), buffer(NULL), palette(NULL), palette332(NULL),
+      stage(NULL),
+      dirty(w, h), bpp(bpp == 8 ? 8 : 4), indexMask(bpp == 8 ? 0xFF : 0x0F),
+      stride(bpp == 8 ? w : (w + 1) / 2), runX(0), runY(0), runW(0), runH(0),
+      runRow(0) {
+  uint32_t bytes = (uint32_t)stride * h;
+  if ((buffer = (uint8_t *)malloc(bytes))) {
+    memset(buffer, 0, bytes);
+  }
+  if ((palette = (uint16_t *)malloc((indexMask + 1) * sizeof(uint16_t)))) {
+    memset(palette, 0, (indexMask + 1) * sizeof(uint16_t));
+  }
+  if ((palette332 = (uint8_t *)malloc(indexMask + 1))) {
+    memset(palette332, 0, indexMask + 1);
+  }
+  stage = (uint16_t *)malloc(2 * w * sizeof(uint16_t));
+  if (!palette || !palette332 || !stage) {
+    free(buffer);
+    buffer = NULL;
+  }
+  dirty.markAll();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Delete the canvas, free memory
+*/
+/**************************************************************************/
+Adafruit_SSD1331_PaletteCanvas::~Adafruit_SSD1331_PaletteCanvas(void) {
+  free(buffer);
+  free(palette);
+  free(palette332);
+  free(stage);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Draw a pixel to the canvas framebuffer
+    @param  x      x coordinate
+    @param  y      y coordinate
+    @param  color  Palette index to draw with
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_PaletteCanvas::drawPixel(int16_t x, int16_t y,
+                                               uint16_t color) {
+  if (!buffer || (x < 0) || (y < 0) || (x >= _width) || (y >= _height))
+    return;
+
+  int16_t t;
+  switch (rotation) {
+  case 1:
+    t = x;
+    x = WIDTH - 1 - y;
+    y = t;
+    break;
+  case 2:
+    x = WIDTH - 1 - x;
+    y = HEIGHT - 1 - y;
+    break;
+  case 3:
+    t = x;
+    x = y;
+    y = HEIGHT - 1 - t;
+    break;
+  }
+
+  uint8_t index = color & indexMask;
+  if (bpp == 8) {
+    buffer[x + y * stride] = index;
+  } else {
+    uint8_t *ptr = &buffer[(x >> 1) + y * stride];
+    if (x & 1)
+      *ptr = (*ptr & 0xF0) | index;
+    else
+      *ptr = (*ptr & 0x0F) | (index << 4);
+  }
+  dirty.markPixel(x, y);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Fill the framebuffer completely with one color
+    @param  color  Palette index to fill with
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_PaletteCanvas::fillScreen(uint16_t color) {
+  if (!buffer)
+    return;
+  uint8_t index = color & indexMask;
+  if (bpp == 4)
+    index |= index << 4;
+  memset(buffer, index, (uint32_t)stride * HEIGHT);
+  dirty.markAll();
+}
+
+/**************************************************************************/
+/*!
+    @brief   Get the palette index of a pixel, in unrotated coordinates
+    @param   x  x coordinate
+    @param   y  y coordinate
+    @return  Palette index, or 0 if out of bounds
+*/
+/**************************************************************************/
+uint8_t Adafruit_SSD1331_PaletteCanvas::getPixel(int16_t x, int16_t y) const {
+  if (!buffer || (x < 0) || (y < 0) || (x >= WIDTH) || (y >= HEIGHT))
+    return 0;
+  if (bpp == 8)
+    return buffer[x + y * stride];
+  uint8_t b = buffer[(x >> 1) + y * stride];
+  return (x & 1) ? (b & 0x0F) : (b >> 4);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Load a run of palette entries. Tiles using any entry that
+    changed are marked dirty.
+    @param  colors  Array of 16-bit 5-6-5 colors
+    @param  count   Number of entries to load
+    @param  first   Index of the first entry to load
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_PaletteCanvas::setPalette(const uint16_t *colors,
+                                                uint16_t count,
+                                                uint8_t first) {
+  for (uint16_t i = 0; i < count && (first + i) <= indexMask; i++) {
+    setPaletteColor(first + i, colors[i]);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Change one palette entry. Only the tiles that use the entry are
+    marked dirty, so color cycling animations re-send as little as possible.
+    @param  index  Palette index
+    @param  color  16-bit 5-6-5 Color
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_PaletteCanvas::setPaletteColor(uint8_t index,
+                                                     uint16_t color) {
+  if (!buffer)
+    return;
+  index &= indexMask;
+  if (palette[index] == color)
+    return;
+  palette[index] = color;
+  palette332[index] = Adafruit_SSD1331::color332(color);
+  markIndexDirty(index);
+}
+
+// Marks every clean tile that contains at least one pixel of the given index.
+void Adafruit_SSD1331_PaletteCanvas::markIndexDirty(uint8_t index) {
+  for (uint8_t ty = 0; ty < dirty.numRows; ty++) {
+    int16_t y0 = ty << SSD1331_TILE_SHIFT;
+    int16_t y1 = min(y0 + SSD1331_TILE_SIZE, (int)HEIGHT);
+    for (uint8_t tx = 0; tx < dirty.cols; tx++) {
+      if (dirty.isDirty(tx, ty))
+        continue;
+      int16_t x0 = tx << SSD1331_TILE_SHIFT;
+      int16_t x1 = min(x0 + SSD1331_TILE_SIZE, (int)WIDTH);
+      bool found = false;
+      for (int16_t y = y0; y < y1 && !found; y++) {
+        for (int16_t x = x0; x < x1; x++) {
+          if (getPixel(x, y) == index) {
+            found = true;
+            break;
+          }
+        }
+      }
+      if (found)
+        dirty.markPixel(x0, y0);
+    }
+  }
+}
+
+// Expands one row of palette indices to 5-6-5 colors.
+void Adafruit_SSD1331_PaletteCanvas::expandRow(int16_t x, int16_t y, int16_t w,
+                                               uint16_t *out) const {
+  if (bpp == 8) {
+    const uint8_t *src = &buffer[x + y * stride];
+    while (w--)
+      *out++ = palette[*src++];
+    return;
+  }
+
+  // 4bpp: each source byte expands to two pixels. x is always tile aligned
+  // (even), so pairs never straddle a byte.
+  const uint8_t *src = &buffer[(x >> 1) + y * stride];
+  for (; w >= 2; w -= 2) {
+    uint8_t b = *src++;
+    *out++ = palette[b >> 4];
+    *out++ = palette[b & 0x0F];
+  }
+  if (w)
+    *out = palette[*src >> 4];
+}
+
+// Same as expandRow(), but through a palette that was already packed to
+// RGB332 for a display in 256 color mode.
+void Adafruit_SSD1331_PaletteCanvas::expandRow332(int16_t x, int16_t y,
+                                                  int16_t w, const uint8_t *lut,
+                                                  uint8_t *out) const {
+  if (bpp == 8) {
+    const uint8_t *src = &buffer[x + y * stride];
+    while (w--)
+      *out++ = lut[*src++];
+    return;
+  }
+
+  const uint8_t *src = &buffer[(x >> 1) + y * stride];
+  for (; w >= 2; w -= 2) {
+    uint8_t b = *src++;
+    *out++ = lut[b >> 4];
+    *out++ = lut[b & 0x0F];
+  }
+  if (w)
+    *out = lut[*src >> 4];
+}
+
+/**************************************************************************/
+/*!
+    @brief  Send the dirty tiles to the display and mark them clean. Runs of
+    adjacent dirty tiles in a tile row are sent through a single address
+    window. The canvas is drawn at the display's origin, in the display's
+    current rotation.
+    @param  display  The display to draw to
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_PaletteCanvas::flush(Adafruit_SSD1331 &display) {
+  service(display, 0xFFFFFFFFUL);
+}
+
+// Makes the next run of dirty tiles on the display the current run.
+// Returns false if nothing on the display is dirty.
+bool Adafruit_SSD1331_PaletteCanvas::nextRun(int16_t maxW, int16_t maxH) {
+  uint8_t ty, tx0, tx1;
+  while (dirty.takeRun(ty, tx0, tx1)) {
+    int16_t x = tx0 << SSD1331_TILE_SHIFT;
+    int16_t y = ty << SSD1331_TILE_SHIFT;
+    if (x >= maxW || y >= maxH)
+      continue;
+    runX = x;
+    runY = runRow = y;
+    runW = min((int16_t)(tx1 << SSD1331_TILE_SHIFT), maxW) - x;
+    runH = min(SSD1331_TILE_SIZE, maxH - y);
+    return true;
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Send dirty tiles for at most about maxUs microseconds, then
+    return, so a big update can be spread over several passes of loop() (or
+    an idle task). The next call carries on from where this one stopped.
+    Work is done a pixel row at a time, so a slice can overrun by up to one
+    row. Tiles drawn to while their run is in progress are marked dirty again
+    and sent on a later pass. Rows may go out by DMA, but the last of them
+    has been sent by the time this returns, so the sketch is free to use the
+    display between slices.
+    @param   display  The display to draw to
+    @param   maxUs    Time slice in microseconds
+    @return  True if there is still work pending
+*/
+/**************************************************************************/
+bool Adafruit_SSD1331_PaletteCanvas::service(Adafruit_SSD1331 &display,
+                                             uint32_t maxUs) {
+  if (!buffer || (runRow >= runY + runH && !dirty.any()))
+    return false;
+
+  uint32_t start = micros();
+  int16_t maxW = min(WIDTH, display.width());
+  int16_t maxH = min(HEIGHT, display.height());
+  bool packed = display.getColorDepth() == SSD1331_COLORDEPTH_256;
+
+  display.startWrite();
+  // The window may have been moved since the last slice, so reopen it for
+  // the rest of the current run.
+  bool reopen = true;
+  uint8_t half = 0;
+  do {
+    if (runRow >= runY + runH) {
+      if (!nextRun(maxW, maxH))
+        break;
+      reopen = true;
+    }
+    if (reopen) {
+      // The last row of the run before may still be going out by DMA, and
+      // the window command mustn't cut into it
+      display.dmaWait();
+      display.setAddrWindow(runX, runRow, runW, runY + runH - runRow);
+      reopen = false;
+    }
+
+    // Alternate between the two staging rows, so one can be expanded while
+    // the other may still be going out by DMA.
+    uint16_t *line = &stage[half ? WIDTH : 0];
+    half ^= 1;
+    if (packed) {
+      // Packed rows reuse the staging buffer
+      expandRow332(runX, runRow, runW, palette332, (uint8_t *)line);
+      display.writePixels332((uint8_t *)line, runW);
+    } else {
+      expandRow(runX, runRow, runW, line);
+      display.writePixels(line, runW, false);
+    }
+    runRow++;
+  } while ((uint32_t)(micros() - start) < maxUs);
+  // Whatever the sketch does next mustn't cut into the last row
+  display.dmaWait();
+  display.endWrite();
+
+  return runRow < runY + runH || dirty.any();
+}
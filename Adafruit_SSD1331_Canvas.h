@@ -0,0 +1,150 @@
+/*!
+ * @file Adafruit_SSD1331_Canvas.h
+ *
+ * Off-screen framebuffers for the SSD1331 driver. Drawing happens in RAM and
+ * only the 8x8 tiles that changed are pushed to the display on flush().
+ */
+
+#ifndef _ADAFRUIT_SSD1331_CANVAS_H_
+#define _ADAFRUIT_SSD1331_CANVAS_H_
+
+#include "Adafruit_SSD1331.h"
+
+#define SSD1331_TILE_SIZE 8       //!< Width and height of a dirty tile
+#define SSD1331_TILE_SHIFT 3      //!< log2(SSD1331_TILE_SIZE)
+#define SSD1331_MAX_TILE_ROWS 16  //!< Max tile rows (canvas height <= 128)
+#define SSD1331_MAX_TILE_COLS 16  //!< Max tile columns (canvas width <= 128)
+
+/// Bitmap of 8x8 tiles that need to be sent to the display
+class SSD1331_DirtyTiles {
+public:
+  SSD1331_DirtyTiles(uint16_t w, uint16_t h);
+
+  void mark(int16_t x, int16_t y, int16_t w, int16_t h);
+  void markAll(void);
+  void clearAll(void);
+
+  /*!
+    @brief   Mark the tile containing a pixel. The pixel must be in bounds.
+    @param   x  Horizontal position
+    @param   y  Vertical position
+  */
+  void markPixel(int16_t x, int16_t y) {
+    rows[y >> SSD1331_TILE_SHIFT] |= 1U << (x >> SSD1331_TILE_SHIFT);
+  }
+  /*!
+    @brief   Check one tile
+    @param   tx  Tile column
+    @param   ty  Tile row
+    @return  True if the tile is dirty
+  */
+  bool isDirty(uint8_t tx, uint8_t ty) const {
+    return rows[ty] & (1U << tx);
+  }
+  /*!
+    @brief   Get the dirty bits for a row of tiles, bit n is tile column n
+    @param   ty  Tile row
+    @return  Dirty bits
+  */
+  uint16_t row(uint8_t ty) const { return rows[ty]; }
+  /*!
+    @brief  Clear the dirty bits for a row of tiles
+    @param  ty    Tile row
+    @param  bits  Bits to clear
+  */
+  void clear(uint8_t ty, uint16_t bits) { rows[ty] &= ~bits; }
+  bool any(void) const;
+  bool takeRun(uint8_t &ty, uint8_t &tx0, uint8_t &tx1);
+
+  uint8_t cols;    ///< Number of tile columns
+  uint8_t numRows; ///< Number of tile rows
+
+private:
+  uint16_t rows[SSD1331_MAX_TILE_ROWS];
+  uint8_t cursorTy; // Where takeRun() resumes the search
+  uint8_t cursorTx;
+};
+
+/// An indexed-color framebuffer (4 or 8 bits per pixel) with a 16-bit
+/// 5-6-5 palette. Colors passed to the GFX drawing functions are palette
+/// indices.
+class Adafruit_SSD1331_PaletteCanvas : public Adafruit_GFX {
+public:
+  Adafruit_SSD1331_PaletteCanvas(uint8_t bpp = 4,
+                                 uint16_t w = Adafruit_SSD1331::TFTWIDTH,
+                                 uint16_t h = Adafruit_SSD1331::TFTHEIGHT);
+  ~Adafruit_SSD1331_PaletteCanvas(void);
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void fillScreen(uint16_t color);
+  uint8_t getPixel(int16_t x, int16_t y) const;
+
+  void setPalette(const uint16_t *colors, uint16_t count, uint8_t first = 0);
+  void setPaletteColor(uint8_t index, uint16_t color);
+  /*!
+    @brief   Get a palette entry
+    @param   index  Palette index
+    @return  16-bit 5-6-5 Color
+  */
+  uint16_t getPaletteColor(uint8_t index) const {
+    return palette[index & indexMask];
+  }
+
+  /*!
+    @brief  Mark an area as needing to be sent on the next flush()
+    @param  x  Top left corner x coordinate
+    @param  y  Top left corner y coordinate
+    @param  w  Width in pixels
+    @param  h  Height in pixels
+  */
+  void markDirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+    dirty.mark(x, y, w, h);
+  }
+  /*!
+    @brief  Mark the whole canvas as needing to be sent on the next flush()
+  */
+  void markAllDirty(void) { dirty.markAll(); }
+  /*!
+    @brief   Check whether anything needs flushing
+    @return  True if any tile is dirty, or a run is partly sent
+  */
+  bool isDirty(void) const { return runRow < runY + runH || dirty.any(); }
+
+  void flush(Adafruit_SSD1331 &display);
+  bool service(Adafruit_SSD1331 &display, uint32_t maxUs);
+
+  /*!
+    @brief   Get a pointer to the internal buffer memory
+    @return  A pointer to the allocated buffer, or NULL if allocation failed
+  */
+  uint8_t *getBuffer(void) const { return buffer; }
+  /*!
+    @brief   Get the number of bits per pixel
+    @return  4 or 8
+  */
+  uint8_t getBitsPerPixel(void) const { return bpp; }
+
+protected:
+  void expandRow(int16_t x, int16_t y, int16_t w, uint16_t *out) const;
+  void expandRow332(int16_t x, int16_t y, int16_t w, const uint8_t *lut,
+                    uint8_t *out) const;
+  void markIndexDirty(uint8_t index);
+  bool nextRun(int16_t maxW, int16_t maxH);
+
+  uint8_t *buffer;   ///< Pixel indices, row-major, packed high nibble first
+  uint16_t *palette; ///< 16-bit 5-6-5 palette
+  uint8_t *palette332; ///< The palette packed to RGB332, kept up to date by
+                       ///< setPaletteColor() for displays in 256 color mode
+  uint16_t *stage;   ///< Two rows of expanded pixels for streaming
+  SSD1331_DirtyTiles dirty; ///< Tiles changed since the last flush
+  uint8_t bpp;       ///< Bits per pixel, 4 or 8
+  uint8_t indexMask; ///< Mask for valid palette indices
+  uint16_t stride;   ///< Bytes per buffer row
+  int16_t runX;      ///< Left edge of the run being sent
+  int16_t runY;      ///< Top edge of the run being sent
+  int16_t runW;      ///< Width of the run being sent
+  int16_t runH;      ///< Height of the run being sent
+  int16_t runRow;    ///< Next pixel row of the run to send
+};
+
+#endif // _ADAFRUIT_SSD1331_CANVAS_H_
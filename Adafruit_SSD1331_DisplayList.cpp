@@ -0,0 +1,336 @@
+/*!
+ * @file Adafruit_SSD1331_DisplayList.cpp
+ *
+ * A retained-mode display list for the SSD1331 driver.
+ *
+ * BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_SSD1331_DisplayList.h"
+
+namespace {
+
+// Draws text onto a display with its own cursor, font, size and color, so
+// text operations leave the sketch's text settings on the display alone.
+class TextPen : public Adafruit_GFX {
+public:
+  TextPen(Adafruit_SSD1331 &display, const GFXfont *font, uint8_t size)
+      : Adafruit_GFX(display.width(), display.height()), display(display) {
+    setFont(font);
+    setTextSize(size);
+  }
+  void drawPixel(int16_t x, int16_t y, uint16_t color) {
+    display.drawPixel(x, y, color);
+  }
+  void startWrite(void) { display.startWrite(); }
+  void writePixel(int16_t x, int16_t y, uint16_t color) {
+    display.writePixel(x, y, color);
+  }
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                     uint16_t color) {
+    display.writeFillRect(x, y, w, h, color);
+  }
+  void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    display.writeFastVLine(x, y, h, color);
+  }
+  void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    display.writeFastHLine(x, y, w, color);
+  }
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    display.fillRect(x, y, w, h, color);
+  }
+  void endWrite(void) { display.endWrite(); }
+
+private:
+  Adafruit_SSD1331 &display;
+};
+
+} // namespace
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate a display list. Two frames of op and text storage are
+    allocated here (the one being recorded and the one on screen).
+    @param  display     The display to draw to
+    @param  background  16-bit 5-6-5 Color used to erase operations
+    @param  maxOps      Maximum number of operations per frame
+    @param  textBytes   Bytes of text storage per frame, including the
+                        terminators
+*/
+/**************************************************************************/
+Adafruit_SSD1331_DisplayList::Adafruit_SSD1331_DisplayList(
+    Adafruit_SSD1331 &display, uint16_t background, uint8_t maxOps,
+    uint16_t textBytes)
+    : display(display), current(0), maxOps(maxOps), textBytes(textBytes),
+      background(background), font(NULL), valid(false), overflow(false) {
+  for (uint8_t i = 0; i < 2; i++) {
+    frames[i].ops = (Op *)malloc(maxOps * sizeof(Op));
+    frames[i].text = (char *)malloc(textBytes);
+    frames[i].count = 0;
+    frames[i].textUsed = 0;
+  }
+  if (!frames[0].ops || !frames[1].ops)
+    this->maxOps = 0;
+  if (!frames[0].text || !frames[1].text)
+    this->textBytes = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Delete the display list, free memory
+*/
+/**************************************************************************/
+Adafruit_SSD1331_DisplayList::~Adafruit_SSD1331_DisplayList(void) {
+  for (uint8_t i = 0; i < 2; i++) {
+    free(frames[i].ops);
+    free(frames[i].text);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start recording a frame. Operations should be recorded in the
+    same order every frame; each one is compared against the operation at the
+    same position in the previous frame.
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_DisplayList::beginFrame(void) {
+  current ^= 1;
+  frames[current].count = 0;
+  frames[current].textUsed = 0;
+  overflow = false;
+}
+
+Adafruit_SSD1331_DisplayList::Op *
+Adafruit_SSD1331_DisplayList::add(uint8_t type, int16_t a, int16_t b,
+                                  int16_t c, int16_t d, uint16_t color) {
+  Frame &f = frames[current];
+  if (f.count >= maxOps) {
+    overflow = true;
+    return NULL;
+  }
+  Op *op = &f.ops[f.count++];
+  op->type = type;
+  op->size = 1;
+  op->a = a;
+  op->b = b;
+  op->c = c;
+  op->d = d;
+  op->color = color;
+  op->text = 0;
+  op->font = NULL;
+  return op;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Record a filled rectangle
+    @param  x      Top left corner x coordinate
+    @param  y      Top left corner y coordinate
+    @param  w      Width in pixels
+    @param  h      Height in pixels
+    @param  color  16-bit 5-6-5 Color to fill with
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_DisplayList::fillRect(int16_t x, int16_t y, int16_t w,
+                                            int16_t h, uint16_t color) {
+  add(OP_FILLRECT, x, y, w, h, color);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Record a rectangle outline
+    @param  x      Top left corner x coordinate
+    @param  y      Top left corner y coordinate
+    @param  w      Width in pixels
+    @param  h      Height in pixels
+    @param  color  16-bit 5-6-5 Color to draw with
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_DisplayList::drawRect(int16_t x, int16_t y, int16_t w,
+                                            int16_t h, uint16_t color) {
+  add(OP_DRAWRECT, x, y, w, h, color);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Record a line
+    @param  x0     Start point x coordinate
+    @param  y0     Start point y coordinate
+    @param  x1     End point x coordinate
+    @param  y1     End point y coordinate
+    @param  color  16-bit 5-6-5 Color to draw with
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_DisplayList::drawLine(int16_t x0, int16_t y0, int16_t x1,
+                                            int16_t y1, uint16_t color) {
+  add(OP_LINE, x0, y0, x1, y1, color);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Record a string, drawn with the font last set with setFont().
+    The text is copied into the list's text storage.
+    @param  x      Cursor x coordinate
+    @param  y      Cursor y coordinate
+    @param  text   The string to draw
+    @param  color  16-bit 5-6-5 Color to draw with
+    @param  size   Text magnification
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_DisplayList::drawText(int16_t x, int16_t y,
+                                            const char *text, uint16_t color,
+                                            uint8_t size) {
+  Frame &f = frames[current];
+  uint16_t len = strlen(text) + 1;
+  if (f.textUsed + len > textBytes) {
+    overflow = true;
+    return;
+  }
+  Op *op = add(OP_TEXT, x, y, 0, 0, color);
+  if (!op)
+    return;
+  op->size = size;
+  op->font = font;
+  op->text = f.textUsed;
+  memcpy(&f.text[f.textUsed], text, len);
+  f.textUsed += len;
+}
+
+// True if two recorded operations would draw exactly the same thing.
+bool Adafruit_SSD1331_DisplayList::same(const Op &op, const Frame &f,
+                                        const Op &other,
+                                        const Frame &g) const {
+  if (op.type != other.type || op.a != other.a || op.b != other.b ||
+      op.c != other.c || op.d != other.d || op.color != other.color ||
+      op.size != other.size || op.font != other.font)
+    return false;
+  if (op.type == OP_TEXT)
+    return strcmp(&f.text[op.text], &g.text[other.text]) == 0;
+  return true;
+}
+
+// Computes the inclusive bounding box of an operation.
+void Adafruit_SSD1331_DisplayList::bounds(const Op &op, const Frame &f,
+                                          int16_t *x0, int16_t *y0,
+                                          int16_t *x1, int16_t *y1) {
+  switch (op.type) {
+  case OP_LINE:
+    *x0 = min(op.a, op.c);
+    *y0 = min(op.b, op.d);
+    *x1 = max(op.a, op.c);
+    *y1 = max(op.b, op.d);
+    break;
+  case OP_TEXT: {
+    uint16_t w, h;
+    TextPen pen(display, op.font, op.size);
+    pen.getTextBounds(&f.text[op.text], op.a, op.b, x0, y0, &w, &h);
+    *x1 = *x0 + w - 1;
+    *y1 = *y0 + h - 1;
+  } break;
+  default:
+    *x0 = op.a;
+    *y0 = op.b;
+    *x1 = op.a + op.c - 1;
+    *y1 = op.b + op.d - 1;
+    break;
+  }
+}
+
+// True if the bounding boxes of two operations intersect.
+bool Adafruit_SSD1331_DisplayList::overlaps(const Op &op, const Frame &f,
+                                            const Op &other, const Frame &g) {
+  int16_t ax0, ay0, ax1, ay1, bx0, by0, bx1, by1;
+  bounds(op, f, &ax0, &ay0, &ax1, &ay1);
+  bounds(other, g, &bx0, &by0, &bx1, &by1);
+  return ax0 <= bx1 && bx0 <= ax1 && ay0 <= by1 && by0 <= ay1;
+}
+
+// Draws an operation, or erases it by drawing it in the background color.
+// Text and filled rects are erased with a single fill of their bounding box,
+// which is cheaper than redrawing them.
+void Adafruit_SSD1331_DisplayList::draw(const Op &op, const Frame &f,
+                                        bool erase) {
+  uint16_t color = erase ? background : op.color;
+  switch (op.type) {
+  case OP_FILLRECT:
+    display.fillRect(op.a, op.b, op.c, op.d, color);
+    break;
+  case OP_DRAWRECT:
+    display.drawRect(op.a, op.b, op.c, op.d, color);
+    break;
+  case OP_LINE:
+    display.drawLine(op.a, op.b, op.c, op.d, color);
+    break;
+  case OP_TEXT:
+    if (erase) {
+      int16_t x0, y0, x1, y1;
+      bounds(op, f, &x0, &y0, &x1, &y1);
+      display.fillRect(x0, y0, x1 - x0 + 1, y1 - y0 + 1, color);
+    } else {
+      TextPen pen(display, op.font, op.size);
+      pen.setTextColor(color);
+      pen.setCursor(op.a, op.b);
+      pen.print(&f.text[op.text]);
+    }
+    break;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Finish the frame and update the display. Operations that differ
+    from the previous frame are erased and redrawn, along with any unchanged
+    operation that overlaps something erased or redrawn beneath it.
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_DisplayList::endFrame(void) {
+  Frame &cur = frames[current];
+  Frame &prev = frames[current ^ 1];
+
+  if (!valid) {
+    display.fillScreen(background);
+    for (uint8_t i = 0; i < cur.count; i++)
+      draw(cur.ops[i], cur, false);
+    valid = true;
+    return;
+  }
+
+  // Bit i of redraw is set for every op in the new frame that has to be
+  // drawn.
+  uint8_t redraw[32];
+#define REDRAW(i) (redraw[(i) >> 3] & (1 << ((i)&7)))
+#define SET_REDRAW(i) (redraw[(i) >> 3] |= (1 << ((i)&7)))
+  memset(redraw, 0, sizeof(redraw));
+  for (uint8_t i = 0; i < cur.count; i++) {
+    if ((i >= prev.count) || !same(cur.ops[i], cur, prev.ops[i], prev))
+      SET_REDRAW(i);
+  }
+
+  // Erase the old version of everything that changed or went away. Anything
+  // unchanged under an erased area has to be redrawn.
+  for (uint8_t i = 0; i < prev.count; i++) {
+    if (i < cur.count && !REDRAW(i))
+      continue;
+    draw(prev.ops[i], prev, true);
+    for (uint8_t j = 0; j < cur.count; j++) {
+      if (!REDRAW(j) && overlaps(cur.ops[j], cur, prev.ops[i], prev))
+        SET_REDRAW(j);
+    }
+  }
+
+  // Redraw in list order to keep the stacking. Anything drawn later in the
+  // list that overlaps a redrawn op has to be redrawn too, or it would end up
+  // underneath.
+  for (uint8_t i = 0; i < cur.count; i++) {
+    if (!REDRAW(i))
+      continue;
+    draw(cur.ops[i], cur, false);
+    for (uint8_t j = i + 1; j < cur.count; j++) {
+      if (!REDRAW(j) && overlaps(cur.ops[j], cur, cur.ops[i], cur))
+        SET_REDRAW(j);
+    }
+  }
+#undef REDRAW
+#undef SET_REDRAW
+}
@@ -0,0 +1,102 @@
+/*!
+ * @file Adafruit_SSD1331_DisplayList.h
+ *
+ * A retained-mode display list for the SSD1331 driver. Each frame's drawing
+ * operations are recorded and compared against the previous frame's, and
+ * only the operations that changed are erased and redrawn, using the
+ * display's hardware-accelerated commands.
+ */
+
+#ifndef _ADAFRUIT_SSD1331_DISPLAYLIST_H_
+#define _ADAFRUIT_SSD1331_DISPLAYLIST_H_
+
+#include "Adafruit_SSD1331.h"
+
+/// Records drawing operations and redraws only what changed between frames
+class Adafruit_SSD1331_DisplayList {
+public:
+  Adafruit_SSD1331_DisplayList(Adafruit_SSD1331 &display,
+                               uint16_t background = 0, uint8_t maxOps = 32,
+                               uint16_t textBytes = 128);
+  ~Adafruit_SSD1331_DisplayList(void);
+
+  void beginFrame(void);
+  void endFrame(void);
+
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                uint16_t color);
+  void drawText(int16_t x, int16_t y, const char *text, uint16_t color,
+                uint8_t size = 1);
+
+  /*!
+    @brief  Set the font for text recorded after this. The display's own
+    font isn't used, so that text operations leave it alone.
+    @param  f  The GFXfont, or NULL for the built-in 6x8 font
+  */
+  void setFont(const GFXfont *f = NULL) { font = f; }
+
+  /*!
+    @brief  Force the next endFrame() to clear the screen and redraw every
+    operation, e.g. after something else has drawn over the display.
+  */
+  void invalidate(void) { valid = false; }
+  /*!
+    @brief  Change the color used to erase operations. Forces a full redraw.
+    @param  color  16-bit 5-6-5 Color
+  */
+  void setBackground(uint16_t color) {
+    background = color;
+    invalidate();
+  }
+  /*!
+    @brief   Check whether operations were dropped in the last frame because
+    the op or text arena was full.
+    @return  True if the last frame didn't fit
+  */
+  bool overflowed(void) const { return overflow; }
+
+private:
+  enum { OP_FILLRECT, OP_DRAWRECT, OP_LINE, OP_TEXT };
+
+  struct Op {
+    uint8_t type;
+    uint8_t size;   // text size
+    int16_t a, b;   // x/y, or x0/y0 for lines
+    int16_t c, d;   // w/h, or x1/y1 for lines
+    uint16_t color;
+    uint16_t text;  // offset into the text arena
+    const GFXfont *font; // text font, NULL for the built-in one
+  };
+
+  /// One frame's worth of recorded operations
+  struct Frame {
+    Op *ops;
+    char *text;
+    uint8_t count;
+    uint16_t textUsed;
+  };
+
+  Op *add(uint8_t type, int16_t a, int16_t b, int16_t c, int16_t d,
+          uint16_t color);
+  bool same(const Op &op, const Frame &f, const Op &other,
+            const Frame &g) const;
+  void bounds(const Op &op, const Frame &f, int16_t *x0, int16_t *y0,
+              int16_t *x1, int16_t *y1);
+  bool overlaps(const Op &op, const Frame &f, const Op &other,
+                const Frame &g);
+  void draw(const Op &op, const Frame &f, bool erase);
+
+  Adafruit_SSD1331 &display;
+  Frame frames[2];
+  uint8_t current;     // Index of the frame being recorded
+  uint8_t maxOps;
+  uint16_t textBytes;
+  uint16_t background;
+  const GFXfont *font; // Font for the next drawText()
+  bool valid;          // False if the screen doesn't match the last frame
+  bool overflow;       // Ran out of op or text space this frame
+};
+
+#endif // _ADAFRUIT_SSD1331_DISPLAYLIST_H_
@@ -0,0 +1,242 @@
+/*!
+ * @file Adafruit_SSD1331_Dither.cpp
+ *
+ * 24-bit RGB to RGB565/RGB332 conversion with ordered or error diffusion
+ * dithering, for the SSD1331 driver.
+ *
+ * BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_SSD1331_Dither.h"
+
+// Reads a byte of a source row from RAM or PROGMEM
+static inline uint8_t readByte(const uint8_t *p, bool progmem) {
+  return progmem ? pgm_read_byte(p) : *p;
+}
+
+// Packs channels, already reduced to the kept bits, to a pixel
+static inline void putPixel(void *out, int16_t i, uint8_t depth, uint8_t r,
+                            uint8_t g, uint8_t b) {
+  if (depth == SSD1331_COLORDEPTH_256)
+    ((uint8_t *)out)[i] = (r << 5) | (g << 2) | b;
+  else
+    ((uint16_t *)out)[i] = ((uint16_t)r << 11) | ((uint16_t)g << 5) | b;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate a converter
+    @param  method  SSD1331_DITHER_NONE, SSD1331_DITHER_BAYER or
+                    SSD1331_DITHER_FLOYD
+*/
+/**************************************************************************/
+Adafruit_SSD1331_Dither::Adafruit_SSD1331_Dither(uint8_t method)
+    : method(method), depth(SSD1331_COLORDEPTH_65K), w(0), x(0), y(0),
+      err(NULL) {}
+
+/**************************************************************************/
+/*!
+    @brief  Delete the converter, free memory
+*/
+/**************************************************************************/
+Adafruit_SSD1331_Dither::~Adafruit_SSD1331_Dither(void) { end(); }
+
+/**************************************************************************/
+/*!
+    @brief  Change the dithering method. Takes effect at the next begin().
+    @param  method  SSD1331_DITHER_NONE, SSD1331_DITHER_BAYER or
+                    SSD1331_DITHER_FLOYD
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Dither::setMethod(uint8_t method) {
+  this->method = method;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start converting an image. Floyd-Steinberg allocates 12 bytes
+    per pixel of width for its error terms, until end().
+    @param  w      Width of the image in pixels
+    @param  depth  Format to convert to, SSD1331_COLORDEPTH_65K or
+                   SSD1331_COLORDEPTH_256 (usually the display's
+                   getColorDepth())
+    @param  x      Screen position of the image's left edge, so the Bayer
+                   pattern lines up from frame to frame
+    @param  y      Screen position of the image's top edge
+    @return true on success, false if there isn't enough memory
+*/
+/**************************************************************************/
+bool Adafruit_SSD1331_Dither::begin(int16_t w, uint8_t depth, int16_t x,
+                                    int16_t y) {
+  end();
+  if (w <= 0)
+    return false;
+  this->depth = depth;
+  this->x = x;
+  this->y = y;
+
+  // RGB565 keeps 5-6-5 bits of each channel, RGB332 3-3-2
+  if (depth == SSD1331_COLORDEPTH_256) {
+    bits[0] = 3;
+    bits[1] = 3;
+    bits[2] = 2;
+  } else {
+    bits[0] = 5;
+    bits[1] = 6;
+    bits[2] = 5;
+  }
+
+  if (method == SSD1331_DITHER_FLOYD) {
+    err = (int16_t *)calloc((w + 2) * 3 * 2, sizeof(int16_t));
+    if (!err)
+      return false;
+  }
+  this->w = w;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Convert the next row of the image started by begin()
+    @param  rgb      w pixels of 3 bytes each, red, green then blue
+    @param  out      Where to put w pixels: uint16_t RGB565 values or
+                     uint8_t RGB332 values, depending on the depth passed
+                     to begin(). Ready for the display's writePixels() or
+                     writePixels332().
+    @param  progmem  True if rgb is in PROGMEM
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Dither::convertRow(const uint8_t *rgb, void *out,
+                                         bool progmem) {
+  if (err) {
+    floydRow(rgb, out, progmem);
+  } else if (method == SSD1331_DITHER_BAYER) {
+    bayerRow(rgb, out, progmem);
+  } else {
+    for (int16_t i = 0; i < w; i++, rgb += 3)
+      putPixel(out, i, depth, readByte(rgb, progmem) >> (8 - bits[0]),
+               readByte(rgb + 1, progmem) >> (8 - bits[1]),
+               readByte(rgb + 2, progmem) >> (8 - bits[2]));
+  }
+  y++;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Finish the image, free the error terms
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Dither::end(void) {
+  free(err);
+  err = NULL;
+  w = 0;
+}
+
+// Ordered dither, with the same thresholds and rounding the driver uses
+// when it packs pixels to RGB332 itself.
+void Adafruit_SSD1331_Dither::bayerRow(const uint8_t *rgb, void *out,
+                                       bool progmem) {
+  uint8_t levels[3], row[4];
+  for (uint8_t c = 0; c < 3; c++)
+    levels[c] = (1 << bits[c]) - 1;
+  for (uint8_t i = 0; i < 4; i++)
+    row[i] = Adafruit_SSD1331::ditherThreshold(i, y);
+
+  for (int16_t i = 0; i < w; i++, rgb += 3) {
+    uint8_t t = row[(x + i) & 3];
+    uint8_t v[3];
+    for (uint8_t c = 0; c < 3; c++)
+      v[c] = Adafruit_SSD1331::ditherLevel(readByte(rgb + c, progmem),
+                                           levels[c], t);
+    putPixel(out, i, depth, v[0], v[1], v[2]);
+  }
+}
+
+// Floyd-Steinberg: round each channel to the nearest level it can show and
+// pass the error on to the pixels right and below (7/16 right, 3/16 below
+// left, 5/16 below, 1/16 below right).
+void Adafruit_SSD1331_Dither::floydRow(const uint8_t *rgb, void *out,
+                                       bool progmem) {
+  int16_t *cur = err + 3;                // This row, 1 pixel of margin
+  int16_t *next = err + (w + 2) * 3 + 3; // The row below
+
+  for (int16_t i = 0; i < w; i++, rgb += 3) {
+    uint8_t q[3];
+    for (uint8_t c = 0; c < 3; c++) {
+      int16_t k = i * 3 + c;
+      int16_t v = readByte(rgb + c, progmem) + cur[k];
+      v = v < 0 ? 0 : (v > 255 ? 255 : v);
+
+      uint8_t levels = (1 << bits[c]) - 1;
+      q[c] = ((uint16_t)v * levels + 127) / 255;
+      int16_t e = v - ((uint16_t)q[c] * 255 + levels / 2) / levels;
+
+      int16_t e7 = e * 7 / 16, e3 = e * 3 / 16, e5 = e * 5 / 16;
+      cur[k + 3] += e7;
+      next[k - 3] += e3;
+      next[k] += e5;
+      next[k + 3] += e - e7 - e3 - e5; // The remainder, about 1/16
+    }
+    putPixel(out, i, depth, q[0], q[1], q[2]);
+  }
+
+  // The row below becomes the current row
+  memcpy(cur - 3, next - 3, (w + 2) * 3 * sizeof(int16_t));
+  memset(next - 3, 0, (w + 2) * 3 * sizeof(int16_t));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Draw a 24-bit RGB bitmap, dithered to the display's current
+    color depth and clipped to the screen
+    @param  display  The display to draw on
+    @param  x        Left edge
+    @param  y        Top edge
+    @param  bitmap   w * h pixels of 3 bytes each, red, green then blue
+    @param  w        Width of the bitmap in pixels
+    @param  h        Height of the bitmap in pixels
+    @param  progmem  True if bitmap is in PROGMEM
+    @return true on success, false if there isn't enough memory
+*/
+/**************************************************************************/
+bool Adafruit_SSD1331_Dither::drawRGB24Bitmap(Adafruit_SSD1331 &display,
+                                              int16_t x, int16_t y,
+                                              const uint8_t *bitmap, int16_t w,
+                                              int16_t h, bool progmem) {
+  int16_t cx = max(x, (int16_t)0), cy = max(y, (int16_t)0);
+  int16_t cw = min((int16_t)(x + w), display.width()) - cx;
+  int16_t ch = min((int16_t)(y + h), display.height()) - cy;
+  if (cw <= 0 || ch <= 0)
+    return true;
+
+  if (!begin(w, display.getColorDepth(), x, y))
+    return false;
+  uint16_t *row = (uint16_t *)malloc(w * sizeof(uint16_t));
+  if (!row) {
+    end();
+    return false;
+  }
+
+  display.startWrite();
+  display.setAddrWindow(cx, cy, cw, ch);
+  int16_t skip = cx - x;
+  for (int16_t j = 0; j < cy + ch - y; j++) {
+    // Rows above the screen only matter for the errors they pass down
+    if (j < cy - y && !err) {
+      this->y++;
+      continue;
+    }
+    convertRow(bitmap + (uint32_t)j * w * 3, row, progmem);
+    if (j < cy - y)
+      continue;
+    if (depth == SSD1331_COLORDEPTH_256)
+      display.writePixels332((uint8_t *)row + skip, cw);
+    else
+      display.writePixels(row + skip, cw);
+  }
+  display.endWrite();
+
+  free(row);
+  end();
+  return true;
+}
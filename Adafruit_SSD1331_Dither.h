@@ -0,0 +1,60 @@
+/*!
+ * @file Adafruit_SSD1331_Dither.h
+ *
+ * Converts 24-bit RGB images (photos, gradients) to the SSD1331's 65k color
+ * (RGB565) or 256 color (RGB332) pixel formats with dithering, instead of
+ * truncating each channel, which leaves visible bands. Bayer ordered
+ * dithering is table-driven and quick enough to use every frame;
+ * Floyd-Steinberg error diffusion looks better but is slower and needs two
+ * rows of error terms, so it suits static assets. Rows can be converted
+ * into a buffer of your own, or streamed straight to the display.
+ */
+
+#ifndef _ADAFRUIT_SSD1331_DITHER_H_
+#define _ADAFRUIT_SSD1331_DITHER_H_
+
+#include "Adafruit_SSD1331.h"
+
+/*!
+ * @brief Dithering methods, for use with Adafruit_SSD1331_Dither
+ */
+#define SSD1331_DITHER_NONE 0  //!< Truncate each channel
+#define SSD1331_DITHER_BAYER 1 //!< 4x4 ordered dither
+#define SSD1331_DITHER_FLOYD 2 //!< Floyd-Steinberg error diffusion
+
+/// Row by row converter from 24-bit RGB to the display's pixel formats
+class Adafruit_SSD1331_Dither {
+public:
+  Adafruit_SSD1331_Dither(uint8_t method = SSD1331_DITHER_BAYER);
+  ~Adafruit_SSD1331_Dither(void);
+
+  void setMethod(uint8_t method);
+  /*!
+    @brief   Get the dithering method
+    @return  SSD1331_DITHER_NONE, SSD1331_DITHER_BAYER or
+             SSD1331_DITHER_FLOYD
+  */
+  uint8_t getMethod(void) const { return method; }
+
+  bool begin(int16_t w, uint8_t depth = SSD1331_COLORDEPTH_65K, int16_t x = 0,
+             int16_t y = 0);
+  void convertRow(const uint8_t *rgb, void *out, bool progmem = false);
+  void end(void);
+
+  bool drawRGB24Bitmap(Adafruit_SSD1331 &display, int16_t x, int16_t y,
+                       const uint8_t *bitmap, int16_t w, int16_t h,
+                       bool progmem = true);
+
+private:
+  void bayerRow(const uint8_t *rgb, void *out, bool progmem);
+  void floydRow(const uint8_t *rgb, void *out, bool progmem);
+
+  uint8_t method;
+  uint8_t depth;   // SSD1331_COLORDEPTH_65K or SSD1331_COLORDEPTH_256
+  uint8_t bits[3]; // Bits kept of red, green and blue
+  int16_t w, x, y; // Row width, and screen position of the next row
+  int16_t *err;    // Floyd-Steinberg error terms, two rows of w + 2 pixels
+                   // by 3 channels, NULL for the other methods
+};
+
+#endif // _ADAFRUIT_SSD1331_DITHER_H_
@@ -0,0 +1,271 @@
+/*!
+ * @file Adafruit_SSD1331_DoubleBuffer.cpp
+ *
+ * Double-buffered 16-bit framebuffer for the SSD1331 driver.
+ *
+ * BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_SSD1331_DoubleBuffer.h"
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate a double buffer. Both buffers are allocated here;
+    check getBuffer() for NULL to see if it succeeded. A 96x64 double buffer
+    takes 24KB, so this is for boards with RAM to spare.
+    @param  display  The display to flush to
+    @param  w        Width in pixels (at most 128)
+    @param  h        Height in pixels (at most 128)
+*/
+/**************************************************************************/
+Adafruit_SSD1331_DoubleBuffer::Adafruit_SSD1331_DoubleBuffer(
+    Adafruit_SSD1331 &display, uint16_t w, uint16_t h)
+    : Adafruit_GFX(w, h), display(display), dirty(w, h), runX(0), runY(0),
+      runW(0), runH(0), runRow(0), busy(false), firstFrame(true) {
+#if defined(ESP32)
+  task = NULL;
+#endif
+  uint32_t bytes = (uint32_t)w * h * sizeof(uint16_t);
+  front = (uint16_t *)malloc(bytes);
+  back = (uint16_t *)malloc(bytes);
+  if (!front || !back) {
+    free(front);
+    free(back);
+    front = back = NULL;
+    return;
+  }
+  memset(front, 0, bytes);
+  memset(back, 0, bytes);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Delete the double buffer, free memory. Any flush task must not
+    be running.
+*/
+/**************************************************************************/
+Adafruit_SSD1331_DoubleBuffer::~Adafruit_SSD1331_DoubleBuffer(void) {
+  free(front);
+  free(back);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Draw a pixel to the back buffer
+    @param  x      x coordinate
+    @param  y      y coordinate
+    @param  color  16-bit 5-6-5 Color to draw with
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_DoubleBuffer::drawPixel(int16_t x, int16_t y,
+                                              uint16_t color) {
+  if (!back || (x < 0) || (y < 0) || (x >= _width) || (y >= _height))
+    return;
+
+  int16_t t;
+  switch (rotation) {
+  case 1:
+    t = x;
+    x = WIDTH - 1 - y;
+    y = t;
+    break;
+  case 2:
+    x = WIDTH - 1 - x;
+    y = HEIGHT - 1 - y;
+    break;
+  case 3:
+    t = x;
+    x = y;
+    y = HEIGHT - 1 - t;
+    break;
+  }
+
+  back[x + y * WIDTH] = color;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Fill the back buffer completely with one color
+    @param  color  16-bit 5-6-5 Color to fill with
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_DoubleBuffer::fillScreen(uint16_t color) {
+  if (!back)
+    return;
+  uint32_t n = (uint32_t)WIDTH * HEIGHT;
+  for (uint32_t i = 0; i < n; i++)
+    back[i] = color;
+}
+
+// Marks the tiles where the new front buffer differs from the frame before
+// it (now the back buffer), and copies them across so the back buffer
+// matches what's on screen.
+void Adafruit_SSD1331_DoubleBuffer::diff(void) {
+  for (uint8_t ty = 0; ty < dirty.numRows; ty++) {
+    int16_t y = ty << SSD1331_TILE_SHIFT;
+    int16_t h = min(SSD1331_TILE_SIZE, HEIGHT - y);
+    for (uint8_t tx = 0; tx < dirty.cols; tx++) {
+      int16_t x = tx << SSD1331_TILE_SHIFT;
+      size_t bytes = min(SSD1331_TILE_SIZE, WIDTH - x) * sizeof(uint16_t);
+      uint32_t offset = (uint32_t)y * WIDTH + x;
+
+      int16_t row = 0;
+      if (!firstFrame) {
+        while (row < h && !memcmp(&front[offset + row * WIDTH],
+                                  &back[offset + row * WIDTH], bytes))
+          row++;
+        if (row == h)
+          continue;
+      }
+      dirty.markPixel(x, y);
+      // Rows above the first difference already match
+      for (; row < h; row++)
+        memcpy(&back[offset + row * WIDTH], &front[offset + row * WIDTH],
+               bytes);
+    }
+  }
+  firstFrame = false;
+}
+
+// Returns once the frame being flushed has been sent. Without a flush task,
+// the rest of it is sent from here.
+void Adafruit_SSD1331_DoubleBuffer::waitForFlush(void) {
+#if defined(ESP32)
+  if (task) {
+    while (isBusy())
+      vTaskDelay(1);
+    return;
+  }
+#endif
+  while (service(0xFFFFFFFFUL))
+    ;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Show the frame drawn in the back buffer. Waits for the previous
+    frame to finish going out, then swaps the buffers and starts sending the
+    tiles that changed. Afterwards the back buffer holds the frame just
+    shown, so the next one can be drawn over it incrementally.
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_DoubleBuffer::swap(void) {
+  if (!front)
+    return;
+  waitForFlush();
+
+  uint16_t *t = front;
+  front = back;
+  back = t;
+  diff();
+
+  if (dirty.any()) {
+    setBusy(true);
+#if defined(ESP32)
+    if (task)
+      xTaskNotifyGive(task);
+#endif
+  }
+}
+
+// Makes the next run of changed tiles on the display the current run.
+// Returns false if the frame is done.
+bool Adafruit_SSD1331_DoubleBuffer::nextRun(int16_t maxW, int16_t maxH) {
+  uint8_t ty, tx0, tx1;
+  while (dirty.takeRun(ty, tx0, tx1)) {
+    int16_t x = tx0 << SSD1331_TILE_SHIFT;
+    int16_t y = ty << SSD1331_TILE_SHIFT;
+    if (x >= maxW || y >= maxH)
+      continue;
+    runX = x;
+    runY = runRow = y;
+    runW = min((int16_t)(tx1 << SSD1331_TILE_SHIFT), maxW) - x;
+    runH = min(SSD1331_TILE_SIZE, maxH - y);
+    return true;
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Send changed tiles of the front buffer for at most about maxUs
+    microseconds, then return, so the sketch can draw the next frame in
+    between. Rows are sent straight from the front buffer, by DMA where the
+    board supports it. Don't call this once a flush task is started.
+    @param   maxUs  Time slice in microseconds
+    @return  True if the frame isn't finished yet
+*/
+/**************************************************************************/
+bool Adafruit_SSD1331_DoubleBuffer::service(uint32_t maxUs) {
+  if (!isBusy())
+    return false;
+
+  uint32_t start = micros();
+  int16_t maxW = min(WIDTH, display.width());
+  int16_t maxH = min(HEIGHT, display.height());
+
+  display.startWrite();
+  bool reopen = true, done = false;
+  do {
+    if (runRow >= runY + runH) {
+      if (!nextRun(maxW, maxH)) {
+        done = true;
+        break;
+      }
+      reopen = true;
+    }
+    if (reopen) {
+      // Reopen the window for the rest of the run, in case other drawing
+      // moved it since the last slice. The last row of the run before may
+      // still be going out, and commands mustn't cut into it.
+      display.dmaWait();
+      display.setAddrWindow(runX, runRow, runW, runY + runH - runRow);
+      reopen = false;
+    }
+    display.writePixels(&front[(uint32_t)runRow * WIDTH + runX], runW, false);
+    runRow++;
+  } while ((uint32_t)(micros() - start) < maxUs);
+  display.dmaWait();
+  display.endWrite();
+
+  // Only now is the front buffer free to be swapped and diffed into
+  if (done)
+    setBusy(false);
+  return !done;
+}
+
+#if defined(ESP32)
+/**************************************************************************/
+/*!
+    @brief   Flush frames from a FreeRTOS task pinned to a core, so that on
+    a dual-core ESP32 rendering and sending run in parallel. Once started,
+    only the task may talk to the display; the sketch just draws and calls
+    swap().
+    @param   core      Core to run the task on (the sketch runs on core 1)
+    @param   priority  FreeRTOS task priority
+    @return  True if the task is running
+*/
+/**************************************************************************/
+bool Adafruit_SSD1331_DoubleBuffer::startFlushTask(uint8_t core,
+                                                   uint8_t priority) {
+  if (task)
+    return true;
+  if (xTaskCreatePinnedToCore(flushTask, "SSD1331", 2048, this, priority,
+                              &task, core) != pdPASS) {
+    task = NULL;
+    return false;
+  }
+  if (isBusy())
+    xTaskNotifyGive(task);
+  return true;
+}
+
+void Adafruit_SSD1331_DoubleBuffer::flushTask(void *arg) {
+  Adafruit_SSD1331_DoubleBuffer *db = (Adafruit_SSD1331_DoubleBuffer *)arg;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    while (db->service(0xFFFFFFFFUL))
+      ;
+  }
+}
+#endif // ESP32
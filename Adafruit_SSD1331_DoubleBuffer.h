@@ -0,0 +1,69 @@
+/*!
+ * @file Adafruit_SSD1331_DoubleBuffer.h
+ *
+ * Double-buffered 16-bit framebuffer for the SSD1331 driver. The sketch
+ * draws the next frame into the back buffer while the front buffer goes
+ * out to the display, and swap() hands frames over. Only the tiles that
+ * differ from the previous frame are sent.
+ */
+
+#ifndef _ADAFRUIT_SSD1331_DOUBLEBUFFER_H_
+#define _ADAFRUIT_SSD1331_DOUBLEBUFFER_H_
+
+#include "Adafruit_SSD1331_Canvas.h"
+
+/// Two full-screen 5-6-5 framebuffers with a diffed flush between them
+class Adafruit_SSD1331_DoubleBuffer : public Adafruit_GFX {
+public:
+  Adafruit_SSD1331_DoubleBuffer(Adafruit_SSD1331 &display,
+                                uint16_t w = Adafruit_SSD1331::TFTWIDTH,
+                                uint16_t h = Adafruit_SSD1331::TFTHEIGHT);
+  ~Adafruit_SSD1331_DoubleBuffer(void);
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void fillScreen(uint16_t color);
+
+  void swap(void);
+  bool service(uint32_t maxUs);
+  /*!
+    @brief   Check whether the last frame is still going out
+    @return  True if tiles of the front buffer remain to be sent
+  */
+  bool flushing(void) const { return isBusy(); }
+
+#if defined(ESP32)
+  bool startFlushTask(uint8_t core = 0, uint8_t priority = 1);
+#endif
+
+  /*!
+    @brief   Get a pointer to the back buffer, the one being drawn to
+    @return  A pointer to the buffer, or NULL if allocation failed
+  */
+  uint16_t *getBuffer(void) const { return back; }
+
+private:
+  void diff(void);
+  bool nextRun(int16_t maxW, int16_t maxH);
+  void waitForFlush(void);
+  // busy is shared with the flush task, which may run on the other core.
+  // Dropping it with release order makes the finished DMA and the last use
+  // of the front buffer visible before swap() sees the flag.
+  bool isBusy(void) const { return __atomic_load_n(&busy, __ATOMIC_ACQUIRE); }
+  void setBusy(bool b) { __atomic_store_n(&busy, b, __ATOMIC_RELEASE); }
+#if defined(ESP32)
+  static void flushTask(void *arg);
+#endif
+
+  Adafruit_SSD1331 &display;
+  uint16_t *front; // Frame being sent
+  uint16_t *back;  // Frame being drawn
+  SSD1331_DirtyTiles dirty; // Tiles of front that differ from the display
+  int16_t runX, runY, runW, runH, runRow; // Run being sent by service()
+  bool busy;       // A frame is being flushed, see isBusy()
+  bool firstFrame; // The display's contents are unknown, send everything
+#if defined(ESP32)
+  TaskHandle_t task; // Flushes on another core, if started
+#endif
+};
+
+#endif // _ADAFRUIT_SSD1331_DOUBLEBUFFER_H_
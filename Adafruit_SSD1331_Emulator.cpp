@@ -0,0 +1,382 @@
+/*!
+ * @file Adafruit_SSD1331_Emulator.cpp
+ *
+ * A command-level model of the SSD1331, fed from the driver's bus tap.
+ *
+ * BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_SSD1331_Emulator.h"
+
+#ifdef SSD1331_BUS_TAP
+
+static const int16_t COLS = Adafruit_SSD1331::TFTWIDTH;
+static const int16_t ROWS = Adafruit_SSD1331::TFTHEIGHT;
+
+// Commands not used by the driver, but that take parameters
+#define SSD1331_CMD_DIMWINDOW 0x24 //!< Dim window
+#define SSD1331_CMD_SCROLLSETUP 0x27 //!< Continuous scrolling setup
+#define SSD1331_CMD_DIMMODE 0xAB   //!< Dim mode setting
+#define SSD1331_CMD_GRAYTABLE 0xB8 //!< Gray scale table
+#define SSD1331_CMD_LOCK 0xFD      //!< Command lock
+
+// Number of parameter bytes that follow a command
+static uint8_t paramCount(uint8_t cmd) {
+  switch (cmd) {
+  case SSD1331_CMD_SETCOLUMN:
+  case SSD1331_CMD_SETROW:
+    return 2;
+  case SSD1331_CMD_DRAWLINE:
+    return 7;
+  case SSD1331_CMD_DRAWRECT:
+    return 10;
+  case SSD1331_CMD_COPY:
+    return 6;
+  case SSD1331_CMD_DIMWINDOW:
+  case SSD1331_CMD_CLEAR:
+    return 4;
+  case SSD1331_CMD_SCROLLSETUP:
+  case SSD1331_CMD_DIMMODE:
+    return 5;
+  case SSD1331_CMD_GRAYTABLE:
+    return 32;
+  case SSD1331_CMD_FILL:
+  case SSD1331_CMD_CONTRASTA:
+  case SSD1331_CMD_CONTRASTB:
+  case SSD1331_CMD_CONTRASTC:
+  case SSD1331_CMD_MASTERCURRENT:
+  case SSD1331_CMD_PRECHARGEA:
+  case SSD1331_CMD_PRECHARGEB:
+  case SSD1331_CMD_PRECHARGEC:
+  case SSD1331_CMD_SETREMAP:
+  case SSD1331_CMD_STARTLINE:
+  case SSD1331_CMD_DISPLAYOFFSET:
+  case SSD1331_CMD_SETMULTIPLEX:
+  case SSD1331_CMD_SETMASTER:
+  case SSD1331_CMD_POWERMODE:
+  case SSD1331_CMD_PRECHARGE:
+  case SSD1331_CMD_CLOCKDIV:
+  case SSD1331_CMD_PRECHARGELEVEL:
+  case SSD1331_CMD_VCOMH:
+  case SSD1331_CMD_LOCK:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+// Color of a drawing engine command: 6 bits each of red, green and blue.
+static uint16_t engineColor(const uint8_t *p) {
+  return ((p[0] >> 1) & 0x1F) << 11 | (p[1] & 0x3F) << 5 | ((p[2] >> 1) & 0x1F);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate an emulator, in the chip's power-on state. Attach it
+    with Adafruit_SSD1331::setBusTap() before begin(). Check getBuffer() for
+    NULL to see if allocation succeeded.
+*/
+/**************************************************************************/
+SSD1331_Emulator::SSD1331_Emulator(void) {
+  ram = (uint16_t *)malloc(COLS * ROWS * sizeof(uint16_t));
+  reset();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Delete the emulator, free memory
+*/
+/**************************************************************************/
+SSD1331_Emulator::~SSD1331_Emulator(void) { free(ram); }
+
+/**************************************************************************/
+/*!
+    @brief  Return to the power-on state: RAM cleared, full address window,
+    65k color without remapping. Also resets the counters.
+*/
+/**************************************************************************/
+void SSD1331_Emulator::reset(void) {
+  if (ram)
+    memset(ram, 0, COLS * ROWS * sizeof(uint16_t));
+  remap = 0x40;
+  fill = 0;
+  mode = SSD1331_CMD_NORMALDISPLAY;
+  colStart = col = 0;
+  colEnd = COLS - 1;
+  rowStart = row = 0;
+  rowEnd = ROWS - 1;
+  pending = -1;
+  have = need = 0;
+  resetCounters();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Zero the byte and delay counters
+*/
+/**************************************************************************/
+void SSD1331_Emulator::resetCounters(void) {
+  cmdBytes = pixelBytes = delayUs = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Decode a byte from the driver
+    @param  b     The byte
+    @param  data  True for pixel data, false for a command or its parameters
+*/
+/**************************************************************************/
+void SSD1331_Emulator::busWrite(uint8_t b, bool data) {
+  if (data) {
+    pixelBytes++;
+    if ((remap & 0xC0) == 0) {
+      // 256 colors, RGB332: widen each field to 5-6-5
+      uint8_t r = b >> 5, g = (b >> 2) & 7, bl = b & 3;
+      writePixel((r << 2 | r >> 1) << 11 | (g << 3 | g) << 5 |
+                 (bl << 3 | bl << 1 | bl >> 1));
+    } else if (pending < 0) {
+      pending = b;
+    } else {
+      writePixel(pending << 8 | b);
+      pending = -1;
+    }
+    return;
+  }
+
+  cmdBytes++;
+  pending = -1;
+  if (have < need) {
+    params[have++] = b;
+  } else {
+    cmd = b;
+    have = 0;
+    need = paramCount(b);
+  }
+  if (have == need)
+    execute();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Note a wait for the drawing engine
+    @param  us  Delay in microseconds
+*/
+/**************************************************************************/
+void SSD1331_Emulator::busDelay(uint16_t us) { delayUs += us; }
+
+// Stores a pixel at the RAM pointer and advances it through the window,
+// by column or by row depending on the address increment mode.
+void SSD1331_Emulator::writePixel(uint16_t color) {
+  if (ram && col < COLS && row < ROWS)
+    ram[row * COLS + col] = color;
+
+  if (remap & 0x01) {
+    if (row++ >= rowEnd) {
+      row = rowStart;
+      if (col++ >= colEnd)
+        col = colStart;
+    }
+  } else {
+    if (col++ >= colEnd) {
+      col = colStart;
+      if (row++ >= rowEnd)
+        row = rowStart;
+    }
+  }
+}
+
+void SSD1331_Emulator::plot(int16_t c, int16_t r, uint16_t color) {
+  if (ram && c >= 0 && c < COLS && r >= 0 && r < ROWS)
+    ram[r * COLS + c] = color;
+}
+
+void SSD1331_Emulator::fillRect(uint8_t c0, uint8_t r0, uint8_t c1,
+                                uint8_t r1, uint16_t color) {
+  for (int16_t r = r0; r <= r1; r++) {
+    for (int16_t c = c0; c <= c1; c++)
+      plot(c, r, color);
+  }
+}
+
+// The datasheet doesn't say how the engine rasterizes lines. This steps
+// along the longer axis from the start point and rounds the other to the
+// nearest pixel. It is deliberately not Adafruit_GFX's algorithm, which
+// swaps the ends and rounds differently, so that lines drawn by the engine
+// are checked against software ones rather than copied from them: the two
+// can differ by a pixel where a line passes halfway between two pixels.
+void SSD1331_Emulator::drawLine(int16_t c0, int16_t r0, int16_t c1,
+                                int16_t r1, uint16_t color) {
+  int16_t dc = c1 - c0, dr = r1 - r0;
+  int16_t n = max(abs(dc), abs(dr));
+  if (!n) {
+    plot(c0, r0, color);
+    return;
+  }
+  for (int16_t i = 0; i <= n; i++) {
+    // Nearest pixel to start + (end - start) * i / n, with halves rounded
+    // away from the start point
+    int16_t ic = (2L * i * abs(dc) + n) / (2 * n);
+    int16_t ir = (2L * i * abs(dr) + n) / (2 * n);
+    plot(c0 + (dc < 0 ? -ic : ic), r0 + (dr < 0 ? -ir : ir), color);
+  }
+}
+
+// Copies a block, in whichever order keeps an overlapping source intact.
+void SSD1331_Emulator::copy(uint8_t c0, uint8_t r0, uint8_t c1, uint8_t r1,
+                            uint8_t dc, uint8_t dr) {
+  if (!ram || c1 < c0 || r1 < r0)
+    return;
+  int16_t w = c1 - c0 + 1, h = r1 - r0 + 1;
+  bool up = dr > r0, left = dc > c0;
+  for (int16_t j = 0; j < h; j++) {
+    int16_t y = up ? h - 1 - j : j;
+    for (int16_t i = 0; i < w; i++) {
+      int16_t x = left ? w - 1 - i : i;
+      int16_t sc = c0 + x, sr = r0 + y;
+      if (sc >= COLS || sr >= ROWS)
+        continue;
+      uint16_t color = ram[sr * COLS + sc];
+      plot(dc + x, dr + y, (fill & 0x10) ? ~color : color);
+    }
+  }
+}
+
+// Runs a command once all its parameters are in.
+void SSD1331_Emulator::execute(void) {
+  const uint8_t *p = params;
+  switch (cmd) {
+  case SSD1331_CMD_SETCOLUMN:
+    colStart = col = p[0];
+    colEnd = p[1];
+    break;
+  case SSD1331_CMD_SETROW:
+    rowStart = row = p[0];
+    rowEnd = p[1];
+    break;
+  case SSD1331_CMD_SETREMAP:
+    remap = p[0];
+    break;
+  case SSD1331_CMD_FILL:
+    fill = p[0];
+    break;
+  case SSD1331_CMD_NORMALDISPLAY:
+  case SSD1331_CMD_DISPLAYALLON:
+  case SSD1331_CMD_DISPLAYALLOFF:
+  case SSD1331_CMD_INVERTDISPLAY:
+    mode = cmd;
+    break;
+  case SSD1331_CMD_DRAWLINE:
+    drawLine(p[0], p[1], p[2], p[3], engineColor(&p[4]));
+    break;
+  case SSD1331_CMD_DRAWRECT:
+    if (fill & 0x01)
+      fillRect(p[0], p[1], p[2], p[3], engineColor(&p[7]));
+    drawLine(p[0], p[1], p[2], p[1], engineColor(&p[4]));
+    drawLine(p[0], p[3], p[2], p[3], engineColor(&p[4]));
+    drawLine(p[0], p[1], p[0], p[3], engineColor(&p[4]));
+    drawLine(p[2], p[1], p[2], p[3], engineColor(&p[4]));
+    break;
+  case SSD1331_CMD_COPY:
+    copy(p[0], p[1], p[2], p[3], p[4], p[5]);
+    break;
+  case SSD1331_CMD_CLEAR:
+    fillRect(p[0], p[1], p[2], p[3], 0);
+    break;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief   Get a pixel as it appears on the panel. Coordinates are those of
+    rotation 0, and the color is what the panel shows, after the remap
+    register's color order and the display mode are applied.
+    @param   x  Horizontal position
+    @param   y  Vertical position
+    @return  16-bit 5-6-5 Color, or 0 if out of bounds
+*/
+/**************************************************************************/
+uint16_t SSD1331_Emulator::getPixel(int16_t x, int16_t y) const {
+  if (!ram || x < 0 || y < 0 || x >= COLS || y >= ROWS)
+    return 0;
+  if (mode == SSD1331_CMD_DISPLAYALLON)
+    return 0xFFFF;
+  if (mode == SSD1331_CMD_DISPLAYALLOFF)
+    return 0;
+
+  // The driver's rotation 0 reverses both columns and rows
+  int16_t c = (remap & 0x02) ? x : COLS - 1 - x;
+  int16_t r = (remap & 0x10) ? y : ROWS - 1 - y;
+  uint16_t color = ram[r * COLS + c];
+  if (remap & 0x04)
+    color = (color << 11) | (color & 0x07E0) | (color >> 11);
+  if (mode == SSD1331_CMD_INVERTDISPLAY)
+    color = ~color;
+  return color;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Checksum the panel image, for compact golden values. Pixels go
+    in row order, each as two bytes, low byte first.
+    @return  CRC-32 (the zlib/PNG one) of the image
+*/
+/**************************************************************************/
+uint32_t SSD1331_Emulator::crc32(void) const {
+  uint32_t crc = 0xFFFFFFFFUL;
+  for (int16_t y = 0; y < ROWS; y++) {
+    for (int16_t x = 0; x < COLS; x++) {
+      uint16_t color = getPixel(x, y);
+      for (uint8_t i = 0; i < 2; i++) {
+        crc ^= i ? color >> 8 : color & 0xFF;
+        for (uint8_t k = 0; k < 8; k++)
+          crc = (crc >> 1) ^ (0xEDB88320UL & -(crc & 1));
+      }
+    }
+  }
+  return ~crc;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Compare the panel image to a golden one
+    @param   golden   96x64 16-bit 5-6-5 image, in row order
+    @param   progmem  True if the image is in PROGMEM, false for RAM
+    @return  Number of pixels that differ
+*/
+/**************************************************************************/
+uint16_t SSD1331_Emulator::compare(const uint16_t *golden,
+                                   bool progmem) const {
+  uint16_t diffs = 0;
+  for (int16_t y = 0; y < ROWS; y++) {
+    for (int16_t x = 0; x < COLS; x++, golden++) {
+      uint16_t want = progmem ? pgm_read_word(golden) : *golden;
+      if (getPixel(x, y) != want)
+        diffs++;
+    }
+  }
+  return diffs;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Write the panel image as a binary PPM (P6) file, e.g. to Serial
+    for capture on the host
+    @param   p  Where to print it
+    @return  Number of bytes written
+*/
+/**************************************************************************/
+size_t SSD1331_Emulator::printPPM(Print &p) const {
+  size_t n = p.print(F("P6\n96 64\n255\n"));
+  for (int16_t y = 0; y < ROWS; y++) {
+    for (int16_t x = 0; x < COLS; x++) {
+      uint16_t color = getPixel(x, y);
+      uint8_t r = color >> 11, g = (color >> 5) & 0x3F, b = color & 0x1F;
+      n += p.write((uint8_t)(r << 3 | r >> 2));
+      n += p.write((uint8_t)(g << 2 | g >> 4));
+      n += p.write((uint8_t)(b << 3 | b >> 2));
+    }
+  }
+  return n;
+}
+
+#endif // SSD1331_BUS_TAP
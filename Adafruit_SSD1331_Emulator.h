@@ -0,0 +1,87 @@
+/*!
+ * @file Adafruit_SSD1331_Emulator.h
+ *
+ * A command-level model of the SSD1331, fed from the driver's bus tap. It
+ * decodes the address window, pixel data, remap and drawing engine commands
+ * into its own copy of the display RAM, so drawing code can be checked for
+ * correctness (against a golden image or checksum) and for the bytes it
+ * sends, without looking at a panel. Requires SSD1331_BUS_TAP to be defined
+ * in Adafruit_SSD1331.h, and 12KB of RAM.
+ */
+
+#ifndef _ADAFRUIT_SSD1331_EMULATOR_H_
+#define _ADAFRUIT_SSD1331_EMULATOR_H_
+
+#include "Adafruit_SSD1331.h"
+
+#ifdef SSD1331_BUS_TAP
+
+/// A bus tap that emulates the display's RAM and drawing engine
+class SSD1331_Emulator : public SSD1331_BusTap {
+public:
+  SSD1331_Emulator(void);
+  ~SSD1331_Emulator(void);
+
+  void busWrite(uint8_t b, bool data);
+  void busDelay(uint16_t us);
+
+  void reset(void);
+  void resetCounters(void);
+
+  uint16_t getPixel(int16_t x, int16_t y) const;
+  uint32_t crc32(void) const;
+  uint16_t compare(const uint16_t *golden, bool progmem = true) const;
+  size_t printPPM(Print &p) const;
+
+  /*!
+    @brief   Get a pointer to the emulated display RAM, 96x64 16-bit pixels
+    in RAM order (before remapping to the panel)
+    @return  A pointer to the buffer, or NULL if allocation failed
+  */
+  uint16_t *getBuffer(void) const { return ram; }
+  /*!
+    @brief   Count of command bytes (D/C low) since the last reset
+    @return  Number of bytes
+  */
+  uint32_t commandBytes(void) const { return cmdBytes; }
+  /*!
+    @brief   Count of pixel data bytes (D/C high) since the last reset
+    @return  Number of bytes
+  */
+  uint32_t dataBytes(void) const { return pixelBytes; }
+  /*!
+    @brief   Total time the driver waited for the drawing engine since the
+    last reset
+    @return  Time in microseconds
+  */
+  uint32_t delayMicros(void) const { return delayUs; }
+
+private:
+  void execute(void);
+  void writePixel(uint16_t color);
+  void fillRect(uint8_t c0, uint8_t r0, uint8_t c1, uint8_t r1,
+                uint16_t color);
+  void drawLine(int16_t c0, int16_t r0, int16_t c1, int16_t r1,
+                uint16_t color);
+  void copy(uint8_t c0, uint8_t r0, uint8_t c1, uint8_t r1, uint8_t dc,
+            uint8_t dr);
+  void plot(int16_t c, int16_t r, uint16_t color);
+
+  uint16_t *ram;
+  uint8_t remap; // Last SETREMAP value
+  uint8_t fill;  // Last FILL value
+  uint8_t mode;  // Normal, all on, all off or inverted (0xA4 to 0xA7)
+  uint8_t colStart, colEnd, rowStart, rowEnd; // Address window
+  uint8_t col, row;                           // RAM pointer
+  int16_t pending; // First byte of a 65k color pixel, or -1
+
+  uint8_t cmd;        // Command being collected
+  uint8_t params[32]; // Its parameters
+  uint8_t have, need; // Parameters collected and expected
+
+  uint32_t cmdBytes, pixelBytes, delayUs;
+};
+
+#endif // SSD1331_BUS_TAP
+
+#endif // _ADAFRUIT_SSD1331_EMULATOR_H_
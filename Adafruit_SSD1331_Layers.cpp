@@ -0,0 +1,356 @@
+/*!
+ * @file Adafruit_SSD1331_Layers.cpp
+ *
+ * Layered compositing for the SSD1331 driver.
+ *
+ * BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_SSD1331_Layers.h"
+
+// Blends two 5-6-5 pixels packed in a word with two others, weighting fg by
+// a/16. The low pixel's red and blue and the high pixel's green go in one
+// word, the remaining fields (shifted down 5) in another, which leaves at
+// least 4 spare bits above every field for the multiply.
+static inline uint32_t blend2(uint32_t fg, uint32_t bg, uint8_t a) {
+  uint32_t fx = fg & 0x07E0F81FUL, bx = bg & 0x07E0F81FUL;
+  uint32_t fy = (fg >> 5) & 0x07C0F83FUL, by = (bg >> 5) & 0x07C0F83FUL;
+  uint32_t x = ((fx * a + bx * (16 - a)) >> 4) & 0x07E0F81FUL;
+  uint32_t y = ((fy * a + by * (16 - a)) >> 4) & 0x07C0F83FUL;
+  return x | (y << 5);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate a layer. The buffer is allocated here; check
+    getBuffer() for NULL to see if it succeeded. The layer starts visible,
+    opaque, without a color key, and filled with black.
+    @param  w  Layer width in pixels (at most 128)
+    @param  h  Layer height in pixels (at most 128)
+    @param  x  Left edge on screen
+    @param  y  Top edge on screen
+*/
+/**************************************************************************/
+Adafruit_SSD1331_Layer::Adafruit_SSD1331_Layer(uint16_t w, uint16_t h,
+                                               int16_t x, int16_t y)
+    : Adafruit_GFX(w, h), dirty(w, h), x(x), y(y), exposedW(0), key(0),
+      useKey(false), visible(true), alpha(SSD1331_ALPHA_OPAQUE) {
+  uint32_t bytes = (uint32_t)w * h * sizeof(uint16_t);
+  if ((buffer = (uint16_t *)malloc(bytes)))
+    memset(buffer, 0, bytes);
+  dirty.markAll();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Delete the layer, free memory
+*/
+/**************************************************************************/
+Adafruit_SSD1331_Layer::~Adafruit_SSD1331_Layer(void) { free(buffer); }
+
+/**************************************************************************/
+/*!
+    @brief  Draw a pixel to the layer framebuffer
+    @param  x      x coordinate
+    @param  y      y coordinate
+    @param  color  16-bit 5-6-5 Color to draw with
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Layer::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if (!buffer || (x < 0) || (y < 0) || (x >= _width) || (y >= _height))
+    return;
+
+  int16_t t;
+  switch (rotation) {
+  case 1:
+    t = x;
+    x = WIDTH - 1 - y;
+    y = t;
+    break;
+  case 2:
+    x = WIDTH - 1 - x;
+    y = HEIGHT - 1 - y;
+    break;
+  case 3:
+    t = x;
+    x = y;
+    y = HEIGHT - 1 - t;
+    break;
+  }
+
+  buffer[x + y * WIDTH] = color;
+  dirty.markPixel(x, y);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Fill the framebuffer completely with one color
+    @param  color  16-bit 5-6-5 Color to fill with
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Layer::fillScreen(uint16_t color) {
+  if (!buffer)
+    return;
+  uint32_t n = (uint32_t)WIDTH * HEIGHT;
+  for (uint32_t i = 0; i < n; i++)
+    buffer[i] = color;
+  dirty.markAll();
+}
+
+// Remembers the area the layer covers now, so what's under it gets
+// recomposited after a move or hide.
+void Adafruit_SSD1331_Layer::expose(void) {
+  if (!exposedW) {
+    exposedX = x;
+    exposedY = y;
+    exposedW = WIDTH;
+    exposedH = HEIGHT;
+    return;
+  }
+  int16_t x1 = max(exposedX + exposedW, x + WIDTH);
+  int16_t y1 = max(exposedY + exposedH, y + HEIGHT);
+  exposedX = min(exposedX, x);
+  exposedY = min(exposedY, y);
+  exposedW = x1 - exposedX;
+  exposedH = y1 - exposedY;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Move the layer on screen
+    @param  x  New left edge
+    @param  y  New top edge
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Layer::setPosition(int16_t x, int16_t y) {
+  if (x == this->x && y == this->y)
+    return;
+  if (visible)
+    expose();
+  this->x = x;
+  this->y = y;
+  dirty.markAll();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Show or hide the layer
+    @param  visible  True to show
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Layer::setVisible(bool visible) {
+  if (visible == this->visible)
+    return;
+  if (visible)
+    dirty.markAll();
+  else
+    expose();
+  this->visible = visible;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set how opaque the layer is. Pixels are blended as alpha/16 of
+    the layer over the rest, except SSD1331_ALPHA_OPAQUE which replaces them
+    and 0 which leaves them alone.
+    @param  alpha  0 to SSD1331_ALPHA_OPAQUE
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Layer::setAlpha(uint8_t alpha) {
+  if (alpha > SSD1331_ALPHA_OPAQUE)
+    alpha = SSD1331_ALPHA_OPAQUE;
+  if (alpha != this->alpha) {
+    this->alpha = alpha;
+    dirty.markAll();
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Make pixels of one color transparent
+    @param  color  16-bit 5-6-5 Color to treat as transparent
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Layer::setColorKey(uint16_t color) {
+  key = color;
+  useKey = true;
+  dirty.markAll();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stop treating any color as transparent
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Layer::clearColorKey(void) {
+  if (useKey) {
+    useKey = false;
+    dirty.markAll();
+  }
+}
+
+// Draws the layer's part of screen row sy, columns sx to sx + w - 1, over
+// what's already in dst.
+void Adafruit_SSD1331_Layer::composeRow(uint16_t *dst, int16_t sx, int16_t sy,
+                                        int16_t w) const {
+  int16_t ly = sy - y;
+  if (!buffer || !visible || !alpha || ly < 0 || ly >= HEIGHT)
+    return;
+  int16_t x0 = max(sx, x);
+  int16_t x1 = min(sx + w, x + WIDTH);
+  if (x0 >= x1)
+    return;
+
+  const uint16_t *src = &buffer[ly * WIDTH + (x0 - x)];
+  dst += x0 - sx;
+  int16_t n = x1 - x0;
+
+  if (alpha >= SSD1331_ALPHA_OPAQUE) {
+    if (!useKey) {
+      memcpy(dst, src, n * sizeof(uint16_t));
+      return;
+    }
+    for (; n--; src++, dst++) {
+      if (*src != key)
+        *dst = *src;
+    }
+    return;
+  }
+
+  for (; n >= 2; n -= 2, src += 2, dst += 2) {
+    uint32_t out = blend2(src[0] | (uint32_t)src[1] << 16,
+                          dst[0] | (uint32_t)dst[1] << 16, alpha);
+    if (!useKey || src[0] != key)
+      dst[0] = out;
+    if (!useKey || src[1] != key)
+      dst[1] = out >> 16;
+  }
+  if (n && (!useKey || *src != key))
+    *dst = blend2(*src, *dst, alpha);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate a compositor with no layers
+    @param  background  16-bit 5-6-5 Color shown where no layer covers
+    @param  w           Screen width in pixels (at most 128)
+    @param  h           Screen height in pixels (at most 128)
+*/
+/**************************************************************************/
+Adafruit_SSD1331_Compositor::Adafruit_SSD1331_Compositor(uint16_t background,
+                                                         uint16_t w,
+                                                         uint16_t h)
+    : numLayers(0), dirty(w, h), background(background), width(w),
+      height(h) {
+  stage = (uint16_t *)malloc(2 * w * sizeof(uint16_t));
+  dirty.markAll();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Delete the compositor, free memory. The layers aren't deleted.
+*/
+/**************************************************************************/
+Adafruit_SSD1331_Compositor::~Adafruit_SSD1331_Compositor(void) {
+  free(stage);
+}
+
+/**************************************************************************/
+/*!
+    @brief   Stack a layer on top of those already added
+    @param   layer  The layer, which must stay valid while the compositor
+                    is used
+    @return  False if SSD1331_MAX_LAYERS layers are already stacked
+*/
+/**************************************************************************/
+bool Adafruit_SSD1331_Compositor::addLayer(Adafruit_SSD1331_Layer *layer) {
+  if (numLayers >= SSD1331_MAX_LAYERS)
+    return false;
+  layers[numLayers++] = layer;
+  layer->dirty.markAll();
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Change the color shown where no layer covers
+    @param  color  16-bit 5-6-5 Color
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Compositor::setBackground(uint16_t color) {
+  if (color != background) {
+    background = color;
+    dirty.markAll();
+  }
+}
+
+// Moves every layer's changes into the screen's dirty tiles.
+void Adafruit_SSD1331_Compositor::gather(void) {
+  for (uint8_t i = 0; i < numLayers; i++) {
+    Adafruit_SSD1331_Layer *l = layers[i];
+    if (l->exposedW) {
+      dirty.mark(l->exposedX, l->exposedY, l->exposedW, l->exposedH);
+      l->exposedW = 0;
+    }
+    if (!l->visible)
+      continue;
+    for (uint8_t ty = 0; ty < l->dirty.numRows; ty++) {
+      uint16_t bits = l->dirty.row(ty);
+      for (uint8_t tx = 0; bits && tx < l->dirty.cols; tx++, bits >>= 1) {
+        if (bits & 1)
+          dirty.mark(l->x + (tx << SSD1331_TILE_SHIFT),
+                     l->y + (ty << SSD1331_TILE_SHIFT), SSD1331_TILE_SIZE,
+                     SSD1331_TILE_SIZE);
+      }
+    }
+    l->dirty.clearAll();
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Recomposite the tiles touched by any layer change and send
+    them. Runs of adjacent dirty tiles in a tile row are sent through a
+    single address window. The screen is drawn at the display's origin, in
+    the display's current rotation.
+    @param  display  The display to draw to
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Compositor::flush(Adafruit_SSD1331 &display) {
+  if (!stage)
+    return;
+  gather();
+
+  int16_t maxW = min((int16_t)width, display.width());
+  int16_t maxH = min((int16_t)height, display.height());
+
+  display.startWrite();
+  uint8_t half = 0;
+  uint8_t ty, tx0, tx1;
+  while (dirty.takeRun(ty, tx0, tx1)) {
+    int16_t x = tx0 << SSD1331_TILE_SHIFT;
+    int16_t y = ty << SSD1331_TILE_SHIFT;
+    if (x >= maxW || y >= maxH)
+      continue;
+    int16_t w = min((int16_t)(tx1 << SSD1331_TILE_SHIFT), maxW) - x;
+    int16_t h = min(SSD1331_TILE_SIZE, maxH - y);
+
+    // The last row of the run before may still be going out by DMA, and
+    // the window command mustn't cut into it
+    display.dmaWait();
+    display.setAddrWindow(x, y, w, h);
+    for (int16_t row = y; row < y + h; row++) {
+      // Alternate between the two staging rows, so one can be composited
+      // while the other may still be going out by DMA.
+      uint16_t *line = &stage[half ? width : 0];
+      half ^= 1;
+      for (int16_t i = 0; i < w; i++)
+        line[i] = background;
+      for (uint8_t l = 0; l < numLayers; l++)
+        layers[l]->composeRow(line, x, row, w);
+      display.writePixels(line, w, false);
+    }
+  }
+  display.dmaWait();
+  display.endWrite();
+}
@@ -0,0 +1,114 @@
+/*!
+ * @file Adafruit_SSD1331_Layers.h
+ *
+ * Layered compositing for the SSD1331 driver. Each layer is a 16-bit
+ * framebuffer with its own dirty tiles, a position on screen, and either a
+ * transparent color key, a 4-bit alpha, or both. Only the screen tiles
+ * touched by a change are recomposited and sent, so showing, hiding or
+ * moving an overlay doesn't mean redrawing what's under it.
+ */
+
+#ifndef _ADAFRUIT_SSD1331_LAYERS_H_
+#define _ADAFRUIT_SSD1331_LAYERS_H_
+
+#include "Adafruit_SSD1331_Canvas.h"
+
+#define SSD1331_MAX_LAYERS 4   //!< Most layers a compositor can stack
+#define SSD1331_ALPHA_OPAQUE 15 //!< Layer alpha for no blending
+
+/// A 16-bit 5-6-5 framebuffer to be stacked by Adafruit_SSD1331_Compositor
+class Adafruit_SSD1331_Layer : public Adafruit_GFX {
+public:
+  Adafruit_SSD1331_Layer(uint16_t w = Adafruit_SSD1331::TFTWIDTH,
+                         uint16_t h = Adafruit_SSD1331::TFTHEIGHT,
+                         int16_t x = 0, int16_t y = 0);
+  ~Adafruit_SSD1331_Layer(void);
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void fillScreen(uint16_t color);
+
+  void setPosition(int16_t x, int16_t y);
+  void setVisible(bool visible);
+  void setAlpha(uint8_t alpha);
+  void setColorKey(uint16_t color);
+  void clearColorKey(void);
+
+  /*!
+    @brief   Get the layer's position on screen
+    @return  Left edge x coordinate
+  */
+  int16_t getX(void) const { return x; }
+  /*!
+    @brief   Get the layer's position on screen
+    @return  Top edge y coordinate
+  */
+  int16_t getY(void) const { return y; }
+  /*!
+    @brief   Check whether the layer is shown
+    @return  True if visible
+  */
+  bool isVisible(void) const { return visible; }
+  /*!
+    @brief   Get a pointer to the internal buffer memory
+    @return  A pointer to the allocated buffer, or NULL if allocation failed
+  */
+  uint16_t *getBuffer(void) const { return buffer; }
+
+private:
+  friend class Adafruit_SSD1331_Compositor;
+
+  void expose(void);
+  void composeRow(uint16_t *dst, int16_t x, int16_t y, int16_t w) const;
+
+  uint16_t *buffer;
+  SSD1331_DirtyTiles dirty; // Changed tiles, in layer coordinates
+  int16_t x, y;             // Position on screen
+  // Screen area the layer used to cover before a move or hide, which must
+  // be recomposited. exposedW is 0 if there isn't one.
+  int16_t exposedX, exposedY, exposedW, exposedH;
+  uint16_t key;
+  bool useKey;
+  bool visible;
+  uint8_t alpha;
+};
+
+/// Stacks layers over a solid background and sends the changed tiles
+class Adafruit_SSD1331_Compositor {
+public:
+  Adafruit_SSD1331_Compositor(uint16_t background = 0,
+                              uint16_t w = Adafruit_SSD1331::TFTWIDTH,
+                              uint16_t h = Adafruit_SSD1331::TFTHEIGHT);
+  ~Adafruit_SSD1331_Compositor(void);
+
+  bool addLayer(Adafruit_SSD1331_Layer *layer);
+  void setBackground(uint16_t color);
+  /*!
+    @brief  Recomposite an area of the screen on the next flush()
+    @param  x  Top left corner x coordinate
+    @param  y  Top left corner y coordinate
+    @param  w  Width in pixels
+    @param  h  Height in pixels
+  */
+  void markDirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+    dirty.mark(x, y, w, h);
+  }
+  /*!
+    @brief  Recomposite the whole screen on the next flush()
+  */
+  void markAllDirty(void) { dirty.markAll(); }
+
+  void flush(Adafruit_SSD1331 &display);
+
+private:
+  void gather(void);
+
+  Adafruit_SSD1331_Layer *layers[SSD1331_MAX_LAYERS]; // Bottom first
+  uint8_t numLayers;
+  SSD1331_DirtyTiles dirty; // Tiles to recomposite, in screen coordinates
+  uint16_t background;
+  uint16_t width;
+  uint16_t height;
+  uint16_t *stage; // Two rows of composited pixels for streaming
+};
+
+#endif // _ADAFRUIT_SSD1331_LAYERS_H_
@@ -0,0 +1,162 @@
+/*!
+ * @file Adafruit_SSD1331_Overlay.cpp
+ *
+ * On-panel frame time and bus byte graph for the SSD1331 driver.
+ *
+ * BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_SSD1331_Overlay.h"
+
+#define OVERFLOW_BIT 0x80 // Bar height flag: the value was off the scale
+
+static const uint16_t TIME_COLOR = 0x07E0;  // Green
+static const uint16_t SLOW_COLOR = 0xF800;  // Red, for frames off the scale
+static const uint16_t BYTES_COLOR = 0x07FF; // Cyan
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate an overlay. It starts disabled.
+    @param  display  The display to draw on
+    @param  x        Left edge of the graph
+    @param  y        Top edge of the graph
+    @param  bars     Number of frames shown, one pixel column each
+    @param  height   Height in pixels: frame times in the top half, bytes
+                     in the bottom half
+*/
+/**************************************************************************/
+Adafruit_SSD1331_Overlay::Adafruit_SSD1331_Overlay(Adafruit_SSD1331 &display,
+                                                   int16_t x, int16_t y,
+                                                   uint8_t bars, uint8_t height)
+    : display(display), x(x), y(y), bars(bars), half(height / 2),
+      fullUs(33333), fullBytes(Adafruit_SSD1331::TFTWIDTH *
+                               Adafruit_SSD1331::TFTHEIGHT * 2),
+      lastFrame(0), on(false), stale(true) {
+  timeBars = (uint8_t *)calloc(bars, 2);
+  byteBars = timeBars ? timeBars + bars : NULL;
+  if (!timeBars)
+    this->bars = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Delete the overlay, free memory
+*/
+/**************************************************************************/
+Adafruit_SSD1331_Overlay::~Adafruit_SSD1331_Overlay(void) { free(timeBars); }
+
+/**************************************************************************/
+/*!
+    @brief  Set the values that fill the graphs. Frames slower than frameUs
+    show as full height red bars.
+    @param  frameUs  Frame time in microseconds, e.g. 33333 for 30fps
+    @param  bytes    Bytes per frame
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Overlay::setScale(uint32_t frameUs, uint32_t bytes) {
+  fullUs = frameUs ? frameUs : 1;
+  fullBytes = bytes ? bytes : 1;
+  stale = true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Show or hide the overlay. Hiding it leaves the last graph on
+    screen until the sketch draws over it; getBounds() gives the area to
+    mark dirty in its own canvas. History is kept while hidden.
+    @param  on  True to show it
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Overlay::setEnabled(bool on) {
+  if (on && !this->on)
+    stale = true;
+  this->on = on;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the area the overlay draws in
+    @param  x  Left edge
+    @param  y  Top edge
+    @param  w  Width in pixels
+    @param  h  Height in pixels
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Overlay::getBounds(int16_t &x, int16_t &y, int16_t &w,
+                                         int16_t &h) const {
+  x = this->x;
+  y = this->y;
+  w = bars;
+  h = half * 2;
+}
+
+uint8_t Adafruit_SSD1331_Overlay::scaleBar(uint32_t value,
+                                           uint32_t full) const {
+  if (value >= full)
+    return half | OVERFLOW_BIT;
+  return (uint64_t)value * half / full;
+}
+
+// Draws bar i of the history in column x. The column must be clear.
+void Adafruit_SSD1331_Overlay::drawBar(uint8_t i, int16_t x) {
+  uint8_t t = timeBars[i] & ~OVERFLOW_BIT, b = byteBars[i] & ~OVERFLOW_BIT;
+  if (t)
+    display.drawFastVLine(x, y + half - t, t,
+                          (timeBars[i] & OVERFLOW_BIT) ? SLOW_COLOR
+                                                       : TIME_COLOR);
+  if (b)
+    display.drawFastVLine(x, y + 2 * half - b, b, BYTES_COLOR);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Draw the whole graph. Call this after the sketch draws over the
+    overlay's area, e.g. after a full-screen flush.
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Overlay::redraw(void) {
+  if (!bars)
+    return;
+  display.fillRect(x, y, bars, half * 2, 0);
+  for (uint8_t i = 0; i < bars; i++)
+    drawBar(i, x + i);
+  stale = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Call once per frame, after the frame is drawn. Adds the time
+    since the last call and the bytes sent to the graph and, if the overlay
+    is shown, scrolls it along by one bar with the drawing engine.
+    @param  bytes  Bytes the frame sent, e.g. from getStats() with
+                   SSD1331_INSTRUMENT or from an SSD1331_TimingModel
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_Overlay::frame(uint32_t bytes) {
+  uint32_t now = micros();
+  uint32_t us = lastFrame ? now - lastFrame : 0;
+  lastFrame = now;
+  if (!bars)
+    return;
+
+  memmove(timeBars, timeBars + 1, bars - 1);
+  memmove(byteBars, byteBars + 1, bars - 1);
+  timeBars[bars - 1] = scaleBar(us, fullUs);
+  byteBars[bars - 1] = scaleBar(bytes, fullBytes);
+
+  if (!on)
+    return;
+  if (stale) {
+    redraw();
+    return;
+  }
+#ifdef SSD1331_EXTRAS
+  // Shift the graph left a column, then clear and draw the new one
+  int16_t last = x + bars - 1;
+  display.copyBits(x + 1, y, bars - 1, half * 2, x, y);
+  display.drawFastVLine(last, y, half * 2, 0);
+  drawBar(bars - 1, last);
+#else
+  redraw();
+#endif
+}
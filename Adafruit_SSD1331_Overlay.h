@@ -0,0 +1,51 @@
+/*!
+ * @file Adafruit_SSD1331_Overlay.h
+ *
+ * On-panel timing diagnostics for the SSD1331: a small bar graph of recent
+ * frame times and bus bytes, drawn in a corner of the screen with the
+ * display's drawing engine only. The overlay draws straight to the display
+ * and keeps no copy of what's under it, so the sketch's own buffers and
+ * dirty tracking are left alone.
+ */
+
+#ifndef _ADAFRUIT_SSD1331_OVERLAY_H_
+#define _ADAFRUIT_SSD1331_OVERLAY_H_
+
+#include "Adafruit_SSD1331.h"
+
+/// Rolling graph of frame times and bytes sent, drawn on the display
+class Adafruit_SSD1331_Overlay {
+public:
+  Adafruit_SSD1331_Overlay(Adafruit_SSD1331 &display, int16_t x = 0,
+                           int16_t y = 0, uint8_t bars = 24,
+                           uint8_t height = 16);
+  ~Adafruit_SSD1331_Overlay(void);
+
+  void setScale(uint32_t frameUs, uint32_t bytes);
+  void setEnabled(bool on);
+  void frame(uint32_t bytes);
+  void redraw(void);
+  void getBounds(int16_t &x, int16_t &y, int16_t &w, int16_t &h) const;
+
+  /*!
+    @brief   Check whether the overlay is shown
+    @return  True if it is drawn each frame
+  */
+  bool enabled(void) const { return on; }
+
+private:
+  void drawBar(uint8_t i, int16_t x);
+  uint8_t scaleBar(uint32_t value, uint32_t full) const;
+
+  Adafruit_SSD1331 &display;
+  int16_t x, y;
+  uint8_t bars, half; // Number of bars, and the height of each graph
+  uint8_t *timeBars;  // Bar heights, oldest first; the top bit marks a
+  uint8_t *byteBars;  // value that went off the scale
+  uint32_t fullUs, fullBytes; // Values that fill a graph
+  uint32_t lastFrame;         // micros() at the last frame()
+  bool on;
+  bool stale; // The graph on screen is out of date, redraw it in full
+};
+
+#endif // _ADAFRUIT_SSD1331_OVERLAY_H_
@@ -0,0 +1,162 @@
+/*!
+ * @file Adafruit_SSD1331_Recorder.cpp
+ *
+ * Records the SSD1331 command/data stream as a replayable macro.
+ *
+ * BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_SSD1331_Recorder.h"
+
+#ifdef SSD1331_BUS_TAP
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate a recorder. Attach it with Adafruit_SSD1331::setBusTap()
+    (offline, if the display doesn't need to be updated while recording),
+    run the drawing code, then call printTo() to get the macro as source.
+    @param  capacity  Size of the recording buffer in bytes
+*/
+/**************************************************************************/
+SSD1331_CommandRecorder::SSD1331_CommandRecorder(uint16_t capacity)
+    : capacity(capacity), used(0), header(0), open(false), finished(false),
+      overflow(false) {
+  if (!(buffer = (uint8_t *)malloc(capacity)))
+    this->capacity = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Delete the recorder, free memory
+*/
+/**************************************************************************/
+SSD1331_CommandRecorder::~SSD1331_CommandRecorder(void) { free(buffer); }
+
+/**************************************************************************/
+/*!
+    @brief  Discard everything recorded so far
+*/
+/**************************************************************************/
+void SSD1331_CommandRecorder::clear(void) {
+  used = 0;
+  open = false;
+  finished = false;
+  overflow = false;
+}
+
+// Makes room for n more bytes, keeping one for the end marker.
+bool SSD1331_CommandRecorder::reserve(uint16_t n) {
+  if (finished || used + n + 1 > capacity) {
+    overflow = true;
+    return false;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Record one byte. Consecutive bytes with the same D/C state are
+    packed into a single chunk.
+    @param  b     The byte
+    @param  data  True if sent with D/C high
+*/
+/**************************************************************************/
+void SSD1331_CommandRecorder::busWrite(uint8_t b, bool data) {
+  if (open) {
+    uint8_t h = buffer[header];
+    bool chunkData = h & SSD1331_MACRO_DATA;
+    if (chunkData == data &&
+        (h & ~SSD1331_MACRO_DATA) < SSD1331_MACRO_MAXRUN) {
+      if (!reserve(1))
+        return;
+      buffer[header]++;
+      buffer[used++] = b;
+      return;
+    }
+  }
+
+  if (!reserve(2))
+    return;
+  header = used;
+  buffer[used++] = data ? (SSD1331_MACRO_DATA | 1) : 1;
+  buffer[used++] = b;
+  open = true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Record a wait for the drawing engine. Back-to-back waits are
+    merged.
+    @param  us  Delay in microseconds
+*/
+/**************************************************************************/
+void SSD1331_CommandRecorder::busDelay(uint16_t us) {
+  if (!us)
+    return;
+  if (!finished && used >= 3 && !open &&
+      buffer[header] == SSD1331_MACRO_DELAY) {
+    uint32_t total = buffer[header + 1] | (buffer[header + 2] << 8);
+    total += us;
+    if (total <= 0xFFFF) {
+      buffer[header + 1] = total;
+      buffer[header + 2] = total >> 8;
+      return;
+    }
+  }
+
+  if (!reserve(3))
+    return;
+  header = used;
+  buffer[used++] = SSD1331_MACRO_DELAY;
+  buffer[used++] = us;
+  buffer[used++] = us >> 8;
+  open = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Terminate the macro. Recording can't continue afterwards
+    without clear().
+    @return  Pointer to the macro (in RAM), or NULL if the buffer
+             couldn't be allocated
+*/
+/**************************************************************************/
+const uint8_t *SSD1331_CommandRecorder::finish(void) {
+  if (!capacity)
+    return NULL;
+  if (!finished)
+    buffer[used++] = SSD1331_MACRO_END;
+  open = false;
+  finished = true;
+  return buffer;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Print the finished macro as a PROGMEM array definition, ready to
+    paste into a sketch and pass to Adafruit_SSD1331::replay().
+    @param   p     Where to print, e.g. Serial
+    @param   name  Name of the array
+    @return  Number of characters printed
+*/
+/**************************************************************************/
+size_t SSD1331_CommandRecorder::printTo(Print &p, const char *name) {
+  if (!finish())
+    return 0;
+
+  size_t n = p.print("const uint8_t ");
+  n += p.print(name);
+  n += p.print("[] PROGMEM = {");
+  for (uint16_t i = 0; i < used; i++) {
+    if (i)
+      n += p.print(',');
+    n += p.print(i % 12 ? " 0x" : "\r\n  0x");
+    if (buffer[i] < 0x10)
+      n += p.print('0');
+    n += p.print(buffer[i], HEX);
+  }
+  n += p.println("\r\n};");
+  return n;
+}
+
+#endif // SSD1331_BUS_TAP
@@ -0,0 +1,54 @@
+/*!
+ * @file Adafruit_SSD1331_Recorder.h
+ *
+ * Records the command/data stream the SSD1331 driver sends, as a macro that
+ * Adafruit_SSD1331::replay() can stream straight back to the display.
+ * Requires SSD1331_BUS_TAP to be defined in Adafruit_SSD1331.h.
+ */
+
+#ifndef _ADAFRUIT_SSD1331_RECORDER_H_
+#define _ADAFRUIT_SSD1331_RECORDER_H_
+
+#include "Adafruit_SSD1331.h"
+
+#ifdef SSD1331_BUS_TAP
+
+/// A bus tap that encodes everything it sees as a replayable macro
+class SSD1331_CommandRecorder : public SSD1331_BusTap {
+public:
+  SSD1331_CommandRecorder(uint16_t capacity = 1024);
+  ~SSD1331_CommandRecorder(void);
+
+  void busWrite(uint8_t b, bool data);
+  void busDelay(uint16_t us);
+
+  void clear(void);
+  const uint8_t *finish(void);
+  size_t printTo(Print &p, const char *name);
+
+  /*!
+    @brief   Get the number of bytes recorded so far
+    @return  Size of the macro in bytes
+  */
+  uint16_t size(void) const { return used; }
+  /*!
+    @brief   Check whether the buffer ran out
+    @return  True if bytes were dropped
+  */
+  bool overflowed(void) const { return overflow; }
+
+private:
+  bool reserve(uint16_t n);
+
+  uint8_t *buffer;
+  uint16_t capacity;
+  uint16_t used;
+  uint16_t header; // Offset of the header of the chunk being added to
+  bool open;       // True if there's a chunk that can be added to
+  bool finished;   // True once the end marker has been added
+  bool overflow;
+};
+
+#endif // SSD1331_BUS_TAP
+
+#endif // _ADAFRUIT_SSD1331_RECORDER_H_
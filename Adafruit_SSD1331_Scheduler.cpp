@@ -0,0 +1,231 @@
+/*!
+ * @file Adafruit_SSD1331_Scheduler.cpp
+ *
+ * Frame pacing for the SSD1331 driver.
+ *
+ * BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_SSD1331_Scheduler.h"
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate a frame scheduler. The default budget is all of the
+    bus time in a frame period.
+    @param  display     The display to draw to
+    @param  fps         Target frames per second
+    @param  spiFreq     SPI clock the display was started with, used to turn
+                        bytes into bus time
+    @param  maxRegions  Most regions that can be pending at once
+*/
+/**************************************************************************/
+Adafruit_SSD1331_FrameScheduler::Adafruit_SSD1331_FrameScheduler(
+    Adafruit_SSD1331 &display, uint8_t fps, uint32_t spiFreq,
+    uint8_t maxRegions)
+    : display(display), maxRegions(maxRegions), count(0), spiFreq(spiFreq),
+      lastFrame(0) {
+  if (!(regions = (Region *)malloc(maxRegions * sizeof(Region))))
+    this->maxRegions = 0;
+  setTargetFps(fps);
+  resetStats();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Delete the scheduler, free memory
+*/
+/**************************************************************************/
+Adafruit_SSD1331_FrameScheduler::~Adafruit_SSD1331_FrameScheduler(void) {
+  free(regions);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Change the target frame rate. Resets the budget to all of the
+    bus time in the new frame period.
+    @param  fps  Target frames per second
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_FrameScheduler::setTargetFps(uint8_t fps) {
+  period = 1000000UL / (fps ? fps : 1);
+  budgetUs = period;
+  budgetBytes = (uint64_t)period * spiFreq / 8000000UL;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Limit how much each frame may send. A frame always draws at
+    least one region, even if that one region is over budget.
+    @param  bytes  Most bytes to send per frame
+    @param  us     Most estimated bus time per frame, including waits for
+                   the drawing engine, in microseconds
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_FrameScheduler::setBudget(uint32_t bytes, uint32_t us) {
+  budgetBytes = bytes;
+  budgetUs = us;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Time taken to send some bytes at the configured SPI clock
+    @param   bytes  Number of bytes
+    @return  Time in microseconds
+*/
+/**************************************************************************/
+uint32_t Adafruit_SSD1331_FrameScheduler::busMicros(uint32_t bytes) const {
+  return (uint64_t)bytes * 8000000UL / spiFreq;
+}
+
+// Bytes a region is expected to send. Without a cost from the caller,
+// assume the area is streamed as pixels through one address window.
+uint32_t
+Adafruit_SSD1331_FrameScheduler::regionBytes(const Region &r) const {
+  if (r.costBytes)
+    return r.costBytes;
+  uint8_t bytesPerPixel = display.getColorDepth() / 8;
+  return SSD1331_BYTES_WINDOW + (uint32_t)r.w * r.h * bytesPerPixel;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Post a region to be redrawn. If the same function and argument
+    are already pending, the areas are merged and the higher priority kept.
+    @param   x          Top left corner x coordinate
+    @param   y          Top left corner y coordinate
+    @param   w          Width in pixels
+    @param   h          Height in pixels
+    @param   draw       Function that redraws the region
+    @param   arg        Passed to draw
+    @param   priority   Higher priorities are drawn first
+    @param   costBytes  Bytes the redraw sends, if known (e.g. a few
+                        accelerated fills); 0 to assume the area is streamed
+                        as pixels
+    @return  False if there was no room for the region
+*/
+/**************************************************************************/
+bool Adafruit_SSD1331_FrameScheduler::invalidate(int16_t x, int16_t y,
+                                                 int16_t w, int16_t h,
+                                                 RegionFunc draw, void *arg,
+                                                 uint8_t priority,
+                                                 uint16_t costBytes) {
+  if (w <= 0 || h <= 0 || !draw)
+    return true;
+
+  for (uint8_t i = 0; i < count; i++) {
+    Region &r = regions[i];
+    if (r.draw == draw && r.arg == arg) {
+      int16_t x1 = max(r.x + r.w, x + w);
+      int16_t y1 = max(r.y + r.h, y + h);
+      r.x = min(r.x, x);
+      r.y = min(r.y, y);
+      r.w = x1 - r.x;
+      r.h = y1 - r.y;
+      r.priority = max(r.priority, priority);
+      r.costBytes = (r.costBytes && costBytes) ? max(r.costBytes, costBytes)
+                                               : 0;
+      return true;
+    }
+  }
+
+  if (count >= maxRegions)
+    return false;
+  Region &r = regions[count++];
+  r.x = x;
+  r.y = y;
+  r.w = w;
+  r.h = h;
+  r.draw = draw;
+  r.arg = arg;
+  r.costBytes = costBytes;
+  r.priority = priority;
+  r.age = 0;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Call as often as possible from loop(). When a frame is due,
+    draws pending regions in priority order until the budget is used up.
+    Regions that don't fit gain a step of priority for each frame they wait,
+    so nothing starves.
+    @return  True if a frame was drawn
+*/
+/**************************************************************************/
+bool Adafruit_SSD1331_FrameScheduler::tick(void) {
+  uint32_t now = micros();
+  if (!count || (uint32_t)(now - lastFrame) < period)
+    return false;
+
+  // Keep the cadence, unless we've fallen more than a frame behind.
+  lastFrame += period;
+  if ((uint32_t)(now - lastFrame) >= period)
+    lastFrame = now;
+
+  uint32_t spentBytes = 0, spentUs = 0;
+  bool drew = false;
+  while (count) {
+    // Highest priority, counting the frames a region has already waited
+    uint8_t best = 0;
+    for (uint8_t i = 1; i < count; i++) {
+      uint16_t p = regions[i].priority + regions[i].age;
+      uint16_t b = regions[best].priority + regions[best].age;
+      if (p > b)
+        best = i;
+    }
+
+    Region r = regions[best];
+    uint32_t bytes = regionBytes(r);
+    uint32_t us = busMicros(bytes);
+    if (r.costBytes)
+      us += Adafruit_SSD1331::engineDelay(r.w, r.h);
+    if (drew &&
+        (spentBytes + bytes > budgetBytes || spentUs + us > budgetUs))
+      break;
+
+    regions[best] = regions[--count];
+    r.draw(display, r.x, r.y, r.w, r.h, r.arg);
+    spentBytes += bytes;
+    spentUs += us;
+    drew = true;
+  }
+
+  // Whatever is left waits for the next frame
+  for (uint8_t i = 0; i < count; i++) {
+    if (regions[i].age < 255)
+      regions[i].age++;
+  }
+  stats.deferred += count;
+
+  uint32_t elapsed = micros() - now;
+  stats.frames++;
+  stats.lastFrameUs = elapsed;
+  if (elapsed > stats.maxFrameUs)
+    stats.maxFrameUs = elapsed;
+  if (elapsed > period)
+    stats.overruns++;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Zero the frame statistics
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_FrameScheduler::resetStats(void) {
+  memset(&stats, 0, sizeof(stats));
+  stats.since = micros();
+}
+
+/**************************************************************************/
+/*!
+    @brief   Frames drawn per second since the stats were reset
+    @return  Frames per second
+*/
+/**************************************************************************/
+uint16_t Adafruit_SSD1331_FrameScheduler::achievedFps(void) const {
+  uint32_t elapsed = micros() - stats.since;
+  if (!elapsed)
+    return 0;
+  return (uint64_t)stats.frames * 1000000UL / elapsed;
+}
@@ -0,0 +1,88 @@
+/*!
+ * @file Adafruit_SSD1331_Scheduler.h
+ *
+ * Frame pacing for the SSD1331 driver. The application posts dirty regions
+ * with a function that redraws them; the scheduler runs them at a target
+ * frame rate, highest priority first, and pushes whatever doesn't fit in the
+ * per-frame bus budget to the next frame.
+ */
+
+#ifndef _ADAFRUIT_SSD1331_SCHEDULER_H_
+#define _ADAFRUIT_SSD1331_SCHEDULER_H_
+
+#include "Adafruit_SSD1331.h"
+
+/// Frame statistics, see Adafruit_SSD1331_FrameScheduler::getStats()
+struct SSD1331_FrameStats {
+  uint32_t frames;      ///< Frames that drew something
+  uint32_t overruns;    ///< Frames that took longer than the frame period
+  uint32_t deferred;    ///< Regions pushed to a later frame by the budget
+  uint32_t lastFrameUs; ///< Time spent drawing the last frame
+  uint32_t maxFrameUs;  ///< Longest frame so far
+  uint32_t since;       ///< micros() when the stats were reset
+};
+
+/// Runs redraws of dirty regions at a fixed frame rate within a bus budget
+class Adafruit_SSD1331_FrameScheduler {
+public:
+  /*!
+    @brief  Redraws a region of the screen. Called with the area that was
+    posted (merged, if it was posted more than once before being drawn) and
+    the argument given to invalidate().
+  */
+  typedef void (*RegionFunc)(Adafruit_SSD1331 &display, int16_t x, int16_t y,
+                             int16_t w, int16_t h, void *arg);
+
+  Adafruit_SSD1331_FrameScheduler(Adafruit_SSD1331 &display, uint8_t fps = 30,
+                                  uint32_t spiFreq = 8000000,
+                                  uint8_t maxRegions = 16);
+  ~Adafruit_SSD1331_FrameScheduler(void);
+
+  void setTargetFps(uint8_t fps);
+  void setBudget(uint32_t bytes, uint32_t us);
+
+  bool invalidate(int16_t x, int16_t y, int16_t w, int16_t h, RegionFunc draw,
+                  void *arg = NULL, uint8_t priority = 0,
+                  uint16_t costBytes = 0);
+  bool tick(void);
+
+  /*!
+    @brief   Get the frame statistics
+    @return  Statistics since the last resetStats()
+  */
+  const SSD1331_FrameStats &getStats(void) const { return stats; }
+  void resetStats(void);
+  uint16_t achievedFps(void) const;
+  /*!
+    @brief   Check whether any regions are waiting to be drawn
+    @return  True if a region is pending
+  */
+  bool pending(void) const { return count > 0; }
+
+  uint32_t busMicros(uint32_t bytes) const;
+
+private:
+  struct Region {
+    int16_t x, y, w, h;
+    RegionFunc draw;
+    void *arg;
+    uint16_t costBytes; // 0 to estimate from the area
+    uint8_t priority;
+    uint8_t age;        // Frames this region has been deferred
+  };
+
+  uint32_t regionBytes(const Region &r) const;
+
+  Adafruit_SSD1331 &display;
+  Region *regions;
+  uint8_t maxRegions;
+  uint8_t count;
+  uint32_t spiFreq;
+  uint32_t period;      // Frame period in microseconds
+  uint32_t budgetBytes; // Per frame
+  uint32_t budgetUs;    // Per frame
+  uint32_t lastFrame;   // micros() at the start of the last frame
+  SSD1331_FrameStats stats;
+};
+
+#endif // _ADAFRUIT_SSD1331_SCHEDULER_H_
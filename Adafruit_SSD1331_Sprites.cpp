@@ -0,0 +1,252 @@
+/*!
+ * @file Adafruit_SSD1331_Sprites.cpp
+ *
+ * A sprite layer for the SSD1331 driver using the hardware copy command.
+ *
+ * BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_SSD1331_Sprites.h"
+
+#ifdef SSD1331_EXTRAS
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate a sprite layer
+    @param  display     The display to draw to
+    @param  maxSprites  Number of sprite slots to allocate
+*/
+/**************************************************************************/
+Adafruit_SSD1331_SpriteLayer::Adafruit_SSD1331_SpriteLayer(
+    Adafruit_SSD1331 &display, uint8_t maxSprites)
+    : display(display), maxSprites(maxSprites), bgColor(0), bgFunc(NULL) {
+  if ((sprites = (Sprite *)malloc(maxSprites * sizeof(Sprite))))
+    memset(sprites, 0, maxSprites * sizeof(Sprite));
+  else
+    this->maxSprites = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Delete the sprite layer, free memory. Sprites stay on screen.
+*/
+/**************************************************************************/
+Adafruit_SSD1331_SpriteLayer::~Adafruit_SSD1331_SpriteLayer(void) {
+  free(sprites);
+}
+
+bool Adafruit_SSD1331_SpriteLayer::onScreen(int16_t x, int16_t y, int16_t w,
+                                            int16_t h) const {
+  return x >= 0 && y >= 0 && x + w <= display.width() &&
+         y + h <= display.height();
+}
+
+bool Adafruit_SSD1331_SpriteLayer::intersects(const Sprite &s, int16_t x,
+                                              int16_t y, int16_t w,
+                                              int16_t h) const {
+  return s.x < x + w && x < s.x + s.w && s.y < y + h && y < s.y + s.h;
+}
+
+// True if a live sprite other than i and skip overlaps sprite i.
+bool Adafruit_SSD1331_SpriteLayer::covered(uint8_t i, uint8_t skip) const {
+  const Sprite &s = sprites[i];
+  for (uint8_t j = 0; j < maxSprites; j++) {
+    if (j != i && j != skip && sprites[j].bitmap &&
+        intersects(sprites[j], s.x, s.y, s.w, s.h))
+      return true;
+  }
+  return false;
+}
+
+void Adafruit_SSD1331_SpriteLayer::draw(const Sprite &s) {
+  if (s.progmem)
+    display.drawRGBBitmap(s.x, s.y, s.bitmap, s.w, s.h);
+  else
+    display.drawRGBBitmap(s.x, s.y, (uint16_t *)s.bitmap, s.w, s.h);
+}
+
+// Draws, in slot order from first, the sprites that overlap an area. A
+// sprite that overlaps one drawn before it is drawn again as well, as it
+// would otherwise end up underneath.
+void Adafruit_SSD1331_SpriteLayer::redraw(uint8_t first, int16_t x, int16_t y,
+                                          int16_t w, int16_t h) {
+  for (uint8_t i = first; i < maxSprites; i++) {
+    Sprite &s = sprites[i];
+    s.redrawn = s.bitmap && intersects(s, x, y, w, h);
+    for (uint8_t j = first; j < i && s.bitmap && !s.redrawn; j++)
+      s.redrawn = sprites[j].redrawn && intersects(sprites[j], s.x, s.y, s.w,
+                                                   s.h);
+    if (s.redrawn)
+      draw(s);
+  }
+}
+
+// Restores the background under an area, clipped to the screen.
+void Adafruit_SSD1331_SpriteLayer::restore(int16_t x, int16_t y, int16_t w,
+                                           int16_t h) {
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  w = min(w, (int16_t)(display.width() - x));
+  h = min(h, (int16_t)(display.height() - y));
+  if (w <= 0 || h <= 0)
+    return;
+
+  if (bgFunc)
+    bgFunc(display, x, y, w, h);
+  else
+    display.fillRect(x, y, w, h, bgColor);
+}
+
+// Restores the part of a sprite's current area that it won't cover once
+// it's at (nx, ny): at most one horizontal and one vertical strip.
+void Adafruit_SSD1331_SpriteLayer::restoreExposed(const Sprite &s, int16_t nx,
+                                                  int16_t ny) {
+  int16_t dx = nx - s.x;
+  int16_t dy = ny - s.y;
+  if (abs(dx) >= s.w || abs(dy) >= s.h) {
+    restore(s.x, s.y, s.w, s.h);
+    return;
+  }
+
+  // Rows the sprite moves off of
+  int16_t y0 = s.y, h0 = s.h;
+  if (dy > 0) {
+    restore(s.x, s.y, s.w, dy);
+    y0 += dy;
+    h0 -= dy;
+  } else if (dy < 0) {
+    restore(s.x, s.y + s.h + dy, s.w, -dy);
+    h0 += dy;
+  }
+
+  // Columns the sprite moves off of, in the rows that are left
+  if (dx > 0)
+    restore(s.x, y0, dx, h0);
+  else if (dx < 0)
+    restore(s.x + s.w + dx, y0, -dx, h0);
+}
+
+/**************************************************************************/
+/*!
+    @brief   Add a sprite and draw it. If another sprite with the same
+    bitmap is fully on screen and not overlapped by any other sprite, the
+    new one is copied from it in hardware.
+    @param   bitmap   16-bit 5-6-5 image, which must stay valid while the
+                      sprite exists
+    @param   w        Width of the image in pixels
+    @param   h        Height of the image in pixels
+    @param   x        Top left corner x coordinate
+    @param   y        Top left corner y coordinate
+    @param   progmem  True if the image is in PROGMEM, false for RAM
+    @return  Sprite id, or -1 if all slots are in use
+*/
+/**************************************************************************/
+int8_t Adafruit_SSD1331_SpriteLayer::add(const uint16_t *bitmap, int16_t w,
+                                         int16_t h, int16_t x, int16_t y,
+                                         bool progmem) {
+  int8_t id = -1;
+  for (uint8_t i = 0; i < maxSprites; i++) {
+    if (!sprites[i].bitmap) {
+      id = i;
+      break;
+    }
+  }
+  if (id < 0)
+    return -1;
+
+  Sprite &s = sprites[id];
+  s.bitmap = bitmap;
+  s.x = x;
+  s.y = y;
+  s.w = w;
+  s.h = h;
+  s.progmem = progmem;
+
+  bool copied = false;
+  if (onScreen(x, y, w, h)) {
+    for (uint8_t i = 0; i < maxSprites && !copied; i++) {
+      const Sprite &src = sprites[i];
+      // Sprites over the source would be copied along with it
+      if (i != id && src.bitmap == bitmap && src.w == w && src.h == h &&
+          onScreen(src.x, src.y, w, h) && !covered(i, id)) {
+        display.copyBits(src.x, src.y, w, h, x, y);
+        copied = true;
+      }
+    }
+  }
+  if (!copied)
+    draw(s);
+
+  // Sprites in later slots stay on top
+  redraw(id + 1, x, y, w, h);
+  return id;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Remove a sprite and restore the background under it
+    @param  id  Sprite returned by add()
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_SpriteLayer::remove(int8_t id) {
+  if (!valid(id))
+    return;
+  Sprite &s = sprites[id];
+  s.bitmap = NULL;
+  restore(s.x, s.y, s.w, s.h);
+
+  // Anything that was underneath shows through again
+  redraw(0, s.x, s.y, s.w, s.h);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Move a sprite. When the sprite is fully on screen before and
+    after the move and doesn't touch any other sprite, it's moved with a
+    hardware copy and only the uncovered background is redrawn. Otherwise
+    the old area is restored and the sprite (plus any sprites it overlaps)
+    is redrawn from its bitmap.
+    @param  id  Sprite returned by add()
+    @param  x   New top left corner x coordinate
+    @param  y   New top left corner y coordinate
+*/
+/**************************************************************************/
+void Adafruit_SSD1331_SpriteLayer::moveTo(int8_t id, int16_t x, int16_t y) {
+  if (!valid(id))
+    return;
+  Sprite &s = sprites[id];
+  if (x == s.x && y == s.y)
+    return;
+
+  // Area covered by both the old and new positions
+  int16_t ux = min(s.x, x), uy = min(s.y, y);
+  int16_t uw = max(s.x, x) + s.w - ux, uh = max(s.y, y) + s.h - uy;
+
+  bool clear = true;
+  for (uint8_t i = 0; i < maxSprites && clear; i++) {
+    if (i != id && sprites[i].bitmap && intersects(sprites[i], ux, uy, uw, uh))
+      clear = false;
+  }
+
+  if (clear && onScreen(s.x, s.y, s.w, s.h) && onScreen(x, y, s.w, s.h)) {
+    display.copyBits(s.x, s.y, s.w, s.h, x, y);
+    restoreExposed(s, x, y);
+    s.x = x;
+    s.y = y;
+    return;
+  }
+
+  restoreExposed(s, x, y);
+  s.x = x;
+  s.y = y;
+  // The union includes the sprite's new position, so it's redrawn too
+  redraw(0, ux, uy, uw, uh);
+}
+
+#endif // SSD1331_EXTRAS
@@ -0,0 +1,90 @@
+/*!
+ * @file Adafruit_SSD1331_Sprites.h
+ *
+ * A sprite layer for the SSD1331 driver. Sprites are moved with the
+ * display's hardware copy command, so only the background uncovered by a
+ * move has to be redrawn, and new instances of an image already on screen
+ * are stamped with a copy instead of re-sending the bitmap.
+ * Requires SSD1331_EXTRAS (for copyBits).
+ */
+
+#ifndef _ADAFRUIT_SSD1331_SPRITES_H_
+#define _ADAFRUIT_SSD1331_SPRITES_H_
+
+#include "Adafruit_SSD1331.h"
+
+#ifdef SSD1331_EXTRAS
+
+/// Moves opaque, rectangular sprites over a static background
+class Adafruit_SSD1331_SpriteLayer {
+public:
+  /*!
+    @brief  Redraws part of the background. Called with the area to restore,
+    already clipped to the screen.
+  */
+  typedef void (*BackgroundFunc)(Adafruit_SSD1331 &display, int16_t x,
+                                 int16_t y, int16_t w, int16_t h);
+
+  Adafruit_SSD1331_SpriteLayer(Adafruit_SSD1331 &display,
+                               uint8_t maxSprites = 16);
+  ~Adafruit_SSD1331_SpriteLayer(void);
+
+  /*!
+    @brief  Use a solid background color (the default is black)
+    @param  color  16-bit 5-6-5 Color
+  */
+  void setBackground(uint16_t color) {
+    bgColor = color;
+    bgFunc = NULL;
+  }
+  /*!
+    @brief  Use a callback to restore the background
+    @param  func  Function that redraws an area of the background
+  */
+  void setBackground(BackgroundFunc func) { bgFunc = func; }
+
+  int8_t add(const uint16_t *bitmap, int16_t w, int16_t h, int16_t x,
+             int16_t y, bool progmem = true);
+  void remove(int8_t id);
+  void moveTo(int8_t id, int16_t x, int16_t y);
+  /*!
+    @brief  Move a sprite relative to its current position
+    @param  id  Sprite returned by add()
+    @param  dx  Horizontal offset
+    @param  dy  Vertical offset
+  */
+  void moveBy(int8_t id, int16_t dx, int16_t dy) {
+    if (valid(id))
+      moveTo(id, sprites[id].x + dx, sprites[id].y + dy);
+  }
+
+private:
+  struct Sprite {
+    const uint16_t *bitmap; // NULL if the slot is free
+    int16_t x, y, w, h;
+    bool progmem;
+    bool redrawn; // Drawn by the current redraw()
+  };
+
+  bool valid(int8_t id) const {
+    return id >= 0 && id < maxSprites && sprites[id].bitmap;
+  }
+  bool onScreen(int16_t x, int16_t y, int16_t w, int16_t h) const;
+  bool intersects(const Sprite &s, int16_t x, int16_t y, int16_t w,
+                  int16_t h) const;
+  bool covered(uint8_t i, uint8_t skip) const;
+  void draw(const Sprite &s);
+  void redraw(uint8_t first, int16_t x, int16_t y, int16_t w, int16_t h);
+  void restore(int16_t x, int16_t y, int16_t w, int16_t h);
+  void restoreExposed(const Sprite &s, int16_t nx, int16_t ny);
+
+  Adafruit_SSD1331 &display;
+  Sprite *sprites;
+  uint8_t maxSprites;
+  uint16_t bgColor;
+  BackgroundFunc bgFunc;
+};
+
+#endif // SSD1331_EXTRAS
+
+#endif // _ADAFRUIT_SSD1331_SPRITES_H_
@@ -0,0 +1,202 @@
+/*!
+ * @file Adafruit_SSD1331_Timing.cpp
+ *
+ * Bus time estimator for SSD1331 frames.
+ *
+ * BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_SSD1331_Timing.h"
+
+// Rough figures for typical cores with the stock SPI library, not using
+// DMA. Measure with the benchmark example to refine them for a board.
+const SSD1331_McuProfile SSD1331_MCU_AVR = {"avr", 250, 150, 3000};
+const SSD1331_McuProfile SSD1331_MCU_SAMD21 = {"samd21", 400, 100, 2000};
+const SSD1331_McuProfile SSD1331_MCU_ESP32 = {"esp32", 200, 100, 1000};
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate a timing model with nothing counted
+*/
+/**************************************************************************/
+SSD1331_TimingModel::SSD1331_TimingModel(void) { reset(); }
+
+/**************************************************************************/
+/*!
+    @brief  Forget everything counted, to start a new frame
+*/
+/**************************************************************************/
+void SSD1331_TimingModel::reset(void) {
+  cmdBytes = pixelBytes = toggles = begins = engineUs = 0;
+  dcData = true;
+}
+
+// A drawing engine command in a transaction of its own: D/C goes low for
+// the command bytes and back high after them.
+void SSD1331_TimingModel::addCommand(uint8_t bytes, uint16_t waitUs) {
+  cmdBytes += bytes;
+  toggles += 2;
+  begins++;
+  engineUs += waitUs;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Count a fillRect() as the driver sends it: a clear command for
+    black, a line for rects 1 pixel wide or high, otherwise a filled rect
+    @param  w      Width in pixels, after clipping to the screen
+    @param  h      Height in pixels, after clipping to the screen
+    @param  color  Fill color
+*/
+/**************************************************************************/
+void SSD1331_TimingModel::addFill(int16_t w, int16_t h, uint16_t color) {
+  if (w <= 0 || h <= 0)
+    return;
+  uint8_t bytes = !color                 ? SSD1331_BYTES_CLEAR
+                  : (w == 1 || h == 1) ? SSD1331_BYTES_LINE
+                                       : SSD1331_BYTES_RECT;
+  addCommand(bytes, Adafruit_SSD1331::engineDelay(w, h));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Count a drawLine(), drawFastHLine() or drawFastVLine()
+*/
+/**************************************************************************/
+void SSD1331_TimingModel::addLine(void) { addCommand(SSD1331_BYTES_LINE, 0); }
+
+/**************************************************************************/
+/*!
+    @brief  Count a drawRect()
+*/
+/**************************************************************************/
+void SSD1331_TimingModel::addRect(void) { addCommand(SSD1331_BYTES_RECT, 0); }
+
+/**************************************************************************/
+/*!
+    @brief  Count a copyBits()
+    @param  w  Width in pixels
+    @param  h  Height in pixels
+*/
+/**************************************************************************/
+void SSD1331_TimingModel::addCopy(int16_t w, int16_t h) {
+  if (w > 0 && h > 0)
+    addCommand(SSD1331_BYTES_COPY, Adafruit_SSD1331::engineDelay(w, h));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Count pixels streamed through an address window, as for a
+    bitmap, text with a background color or a canvas flush
+    @param  w              Width in pixels
+    @param  h              Height in pixels
+    @param  bytesPerPixel  2 in 65k color mode, 1 in 256 color mode
+*/
+/**************************************************************************/
+void SSD1331_TimingModel::addPixels(int16_t w, int16_t h,
+                                    uint8_t bytesPerPixel) {
+  if (w <= 0 || h <= 0)
+    return;
+  addCommand(SSD1331_BYTES_WINDOW, 0);
+  pixelBytes += (uint32_t)w * h * bytesPerPixel;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Count a byte the driver sent. Attach the model with
+    Adafruit_SSD1331::setBusTap(), offline, and draw the frame to count
+    exactly what it sends, or replay a trace into it.
+    @param  b     The byte
+    @param  data  True if sent with D/C high
+*/
+/**************************************************************************/
+void SSD1331_TimingModel::busWrite(uint8_t b, bool data) {
+  (void)b;
+  if (data != dcData) {
+    toggles++;
+    dcData = data;
+  }
+  if (data)
+    pixelBytes++;
+  else
+    cmdBytes++;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Count a wait for the drawing engine
+    @param  us  Delay in microseconds
+*/
+/**************************************************************************/
+void SSD1331_TimingModel::busDelay(uint16_t us) { engineUs += us; }
+
+/**************************************************************************/
+/*!
+    @brief  Count an SPI transaction
+*/
+/**************************************************************************/
+void SSD1331_TimingModel::busBegin(void) { begins++; }
+
+/**************************************************************************/
+/*!
+    @brief   Estimate the time to send everything counted so far
+    @param   spiHz  SPI clock in Hz
+    @param   mcu    Overheads of the microcontroller
+    @return  Time in microseconds
+*/
+/**************************************************************************/
+uint32_t SSD1331_TimingModel::frameMicros(uint32_t spiHz,
+                                          const SSD1331_McuProfile &mcu) const {
+  uint32_t bytes = cmdBytes + pixelBytes;
+  uint64_t ns = (uint64_t)bytes * 8000000000ULL / spiHz;
+  ns += (uint64_t)bytes * mcu.byteNs;
+  ns += (uint64_t)toggles * mcu.toggleNs;
+  ns += (uint64_t)begins * mcu.transactionNs;
+  return ns / 1000 + engineUs;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Estimate the frame rate, if every frame sends what was counted
+    @param   spiHz  SPI clock in Hz
+    @param   mcu    Overheads of the microcontroller
+    @return  Frames per second
+*/
+/**************************************************************************/
+float SSD1331_TimingModel::fps(uint32_t spiHz,
+                               const SSD1331_McuProfile &mcu) const {
+  uint32_t us = frameMicros(spiHz, mcu);
+  return us ? 1000000.0 / us : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Print the estimated frame time and rate for every combination
+    of SPI clock and microcontroller, as CSV lines of
+    mcu,spi_hz,frame_us,fps
+    @param   p        Where to print, e.g. Serial
+    @param   spiHz    SPI clocks in Hz
+    @param   numHz    Number of SPI clocks
+    @param   mcus     Microcontroller profiles
+    @param   numMcus  Number of profiles
+    @return  Number of characters printed
+*/
+/**************************************************************************/
+size_t SSD1331_TimingModel::printTable(Print &p, const uint32_t *spiHz,
+                                       uint8_t numHz,
+                                       const SSD1331_McuProfile *mcus,
+                                       uint8_t numMcus) const {
+  size_t n = p.println("mcu,spi_hz,frame_us,fps");
+  for (uint8_t m = 0; m < numMcus; m++) {
+    for (uint8_t f = 0; f < numHz; f++) {
+      n += p.print(mcus[m].name);
+      n += p.print(',');
+      n += p.print(spiHz[f]);
+      n += p.print(',');
+      n += p.print(frameMicros(spiHz[f], mcus[m]));
+      n += p.print(',');
+      n += p.println(fps(spiHz[f], mcus[m]), 1);
+    }
+  }
+  return n;
+}
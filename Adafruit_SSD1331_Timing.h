@@ -0,0 +1,89 @@
+/*!
+ * @file Adafruit_SSD1331_Timing.h
+ *
+ * Estimates how long a frame takes to send to the SSD1331, from a list of
+ * draw calls or (with SSD1331_BUS_TAP defined in Adafruit_SSD1331.h) from
+ * the driver's actual bus traffic. The estimate counts bytes, D/C toggles,
+ * transactions and waits for the drawing engine, using the same byte counts
+ * and engine delay as the driver, and turns them into a frame time for a
+ * given SPI clock and microcontroller.
+ */
+
+#ifndef _ADAFRUIT_SSD1331_TIMING_H_
+#define _ADAFRUIT_SSD1331_TIMING_H_
+
+#include "Adafruit_SSD1331.h"
+
+/// CPU overheads of a microcontroller, on top of the time bits take on SPI
+struct SSD1331_McuProfile {
+  const char *name;        ///< Name, for printed tables
+  uint16_t byteNs;         ///< Gap between bytes, in nanoseconds
+  uint16_t toggleNs;       ///< D/C line change, in nanoseconds
+  uint16_t transactionNs;  ///< startWrite() plus endWrite(), in nanoseconds
+};
+
+extern const SSD1331_McuProfile SSD1331_MCU_AVR;    ///< 16MHz AVR (Uno)
+extern const SSD1331_McuProfile SSD1331_MCU_SAMD21; ///< 48MHz SAMD21 (M0)
+extern const SSD1331_McuProfile SSD1331_MCU_ESP32;  ///< 240MHz ESP32
+
+/// Bus time estimator for SSD1331 frames
+class SSD1331_TimingModel
+#ifdef SSD1331_BUS_TAP
+    : public SSD1331_BusTap
+#endif
+{
+public:
+  SSD1331_TimingModel(void);
+
+  void reset(void);
+
+  void addFill(int16_t w, int16_t h, uint16_t color);
+  void addLine(void);
+  void addRect(void);
+  void addCopy(int16_t w, int16_t h);
+  void addPixels(int16_t w, int16_t h, uint8_t bytesPerPixel = 2);
+
+  // Counting the driver's traffic, as a bus tap
+  void busWrite(uint8_t b, bool data);
+  void busDelay(uint16_t us);
+  void busBegin(void);
+
+  uint32_t frameMicros(uint32_t spiHz, const SSD1331_McuProfile &mcu) const;
+  float fps(uint32_t spiHz, const SSD1331_McuProfile &mcu) const;
+  size_t printTable(Print &p, const uint32_t *spiHz, uint8_t numHz,
+                    const SSD1331_McuProfile *mcus, uint8_t numMcus) const;
+
+  /*!
+    @brief   Bytes sent with D/C low
+    @return  Number of bytes
+  */
+  uint32_t commandBytes(void) const { return cmdBytes; }
+  /*!
+    @brief   Bytes sent with D/C high
+    @return  Number of bytes
+  */
+  uint32_t dataBytes(void) const { return pixelBytes; }
+  /*!
+    @brief   Changes of the D/C line
+    @return  Number of changes
+  */
+  uint32_t dcToggles(void) const { return toggles; }
+  /*!
+    @brief   SPI transactions started
+    @return  Number of transactions
+  */
+  uint32_t transactions(void) const { return begins; }
+  /*!
+    @brief   Time the driver waits for the drawing engine
+    @return  Time in microseconds
+  */
+  uint32_t engineMicros(void) const { return engineUs; }
+
+private:
+  void addCommand(uint8_t bytes, uint16_t waitUs);
+
+  uint32_t cmdBytes, pixelBytes, toggles, begins, engineUs;
+  bool dcData; // Last D/C state seen by busWrite()
+};
+
+#endif // _ADAFRUIT_SSD1331_TIMING_H_
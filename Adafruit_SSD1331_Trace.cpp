@@ -0,0 +1,426 @@
+/*!
+ * @file Adafruit_SSD1331_Trace.cpp
+ *
+ * Ring-buffer trace of the SSD1331's SPI transactions.
+ *
+ * BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_SSD1331_Trace.h"
+
+#ifdef SSD1331_BUS_TAP
+
+/**************************************************************************/
+/*!
+    @brief  Instantiate a trace recorder. Attach it with
+    Adafruit_SSD1331::setBusTap() before calling begin(), so the trace starts
+    with the panel's setup, and leave it running; it only ever holds the most
+    recent transactions. Each transaction takes 16 bytes of RAM and two calls
+    to micros(), and each byte sent takes a little over a byte.
+    @param  transactions  Number of transactions to keep
+    @param  bytes         Number of bytes to keep, shared between them
+*/
+/**************************************************************************/
+SSD1331_TraceRecorder::SSD1331_TraceRecorder(uint16_t transactions,
+                                             uint16_t bytes)
+    : maxEntries(transactions), maxBytes(bytes) {
+  entries = (SSD1331_TraceEntry *)malloc(transactions *
+                                         sizeof(SSD1331_TraceEntry));
+  this->bytes = (uint8_t *)malloc(bytes);
+  dcBits = (uint8_t *)malloc((bytes + 7) / 8);
+  if (!entries || !this->bytes || !dcBits || !transactions || !bytes) {
+    free(entries);
+    free(this->bytes);
+    free(dcBits);
+    entries = NULL;
+    this->bytes = dcBits = NULL;
+    maxEntries = maxBytes = 0;
+  }
+  clear();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Delete the trace recorder, free memory
+*/
+/**************************************************************************/
+SSD1331_TraceRecorder::~SSD1331_TraceRecorder(void) {
+  free(entries);
+  free(bytes);
+  free(dcBits);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Discard the trace
+*/
+/**************************************************************************/
+void SSD1331_TraceRecorder::clear(void) {
+  head = count = 0;
+  byteHead = byteCount = 0;
+  lost = 0;
+  open = false;
+  baseRemap = -1;
+  remapNext = false;
+  tokLen = field = 0;
+  parseData = true;
+  comment = false;
+}
+
+// Starts a transaction, dropping the oldest if the ring is full
+void SSD1331_TraceRecorder::newEntry(uint32_t start) {
+  if (!maxEntries)
+    return;
+  if (count == maxEntries)
+    dropOldest();
+  SSD1331_TraceEntry &e = entries[head];
+  e.start = e.end = start;
+  e.first = byteHead;
+  e.length = e.waitUs = 0;
+  e.flags = 0;
+  if (++head == maxEntries)
+    head = 0;
+  count++;
+  open = true;
+}
+
+// Drops the oldest transaction and its bytes, which are the oldest held
+void SSD1331_TraceRecorder::dropOldest(void) {
+  SSD1331_TraceEntry &e = oldest();
+  for (uint16_t i = 0; i < e.length; i++)
+    forget((e.first + i) % maxBytes);
+  byteCount -= e.length;
+  count--;
+  lost++;
+}
+
+// Keeps track of the remap setting as a byte falls off the trace
+void SSD1331_TraceRecorder::forget(uint16_t at) {
+  if (dcBits[at >> 3] & (1 << (at & 7))) {
+    // The parameter of SETREMAP is sent with D/C low, like a command
+    return;
+  }
+  if (remapNext)
+    baseRemap = bytes[at];
+  remapNext = !remapNext && bytes[at] == SSD1331_CMD_SETREMAP;
+}
+
+// Adds a byte to the newest transaction, starting one if none is open
+void SSD1331_TraceRecorder::addByte(uint8_t b, bool data) {
+  if (!open)
+    newEntry(micros());
+  if (!count)
+    return;
+
+  if (byteCount == maxBytes) {
+    // Transactions that sent nothing hold no bytes to free
+    while (count > 1 && !oldest().length) {
+      count--;
+      lost++;
+    }
+    // A transaction longer than the whole ring keeps its last bytes
+    SSD1331_TraceEntry &o = oldest();
+    forget(o.first);
+    if (++o.first == maxBytes)
+      o.first = 0;
+    o.length--;
+    o.flags |= SSD1331_TRACE_TRUNCATED;
+    byteCount--;
+    if (!o.length && count > 1) {
+      count--;
+      lost++;
+    }
+  }
+
+  bytes[byteHead] = b;
+  if (data)
+    dcBits[byteHead >> 3] |= 1 << (byteHead & 7);
+  else
+    dcBits[byteHead >> 3] &= ~(1 << (byteHead & 7));
+  if (++byteHead == maxBytes)
+    byteHead = 0;
+  byteCount++;
+  newest().length++;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start recording a transaction
+*/
+/**************************************************************************/
+void SSD1331_TraceRecorder::busBegin(void) { newEntry(micros()); }
+
+/**************************************************************************/
+/*!
+    @brief  Record one byte of the current transaction
+    @param  b     The byte
+    @param  data  True if sent with D/C high
+*/
+/**************************************************************************/
+void SSD1331_TraceRecorder::busWrite(uint8_t b, bool data) {
+  addByte(b, data);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Record a wait for the drawing engine
+    @param  us  Delay in microseconds
+*/
+/**************************************************************************/
+void SSD1331_TraceRecorder::busDelay(uint16_t us) {
+  if (!count)
+    return;
+  SSD1331_TraceEntry &e = newest();
+  e.waitUs = (uint32_t)e.waitUs + us > 0xFFFF ? 0xFFFF : e.waitUs + us;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Finish recording the current transaction
+*/
+/**************************************************************************/
+void SSD1331_TraceRecorder::busEnd(void) {
+  if (!open)
+    return;
+  newest().end = micros();
+  open = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Get a transaction of the trace
+    @param   i  Index, 0 being the oldest transaction held
+    @param   e  Where to copy the entry
+    @return  False if there's no such transaction
+*/
+/**************************************************************************/
+bool SSD1331_TraceRecorder::get(uint16_t i, SSD1331_TraceEntry &e) const {
+  if (i >= count)
+    return false;
+  e = entries[((uint32_t)head + maxEntries - count + i) % maxEntries];
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Get a byte sent in a transaction
+    @param   e     Entry returned by get()
+    @param   i     Index of the byte, less than e.length
+    @param   data  Set to true if it was sent with D/C high
+    @return  The byte
+*/
+/**************************************************************************/
+uint8_t SSD1331_TraceRecorder::getByte(const SSD1331_TraceEntry &e,
+                                       uint16_t i, bool &data) const {
+  uint16_t at = ((uint32_t)e.first + i) % maxBytes;
+  data = dcBits[at >> 3] & (1 << (at & 7));
+  return bytes[at];
+}
+
+static size_t printHex(Print &p, uint8_t b) {
+  size_t n = p.print(' ');
+  if (b < 0x10)
+    n += p.print('0');
+  return n + p.print(b, HEX);
+}
+
+/**************************************************************************/
+/*!
+    @brief   Print the trace as text, one transaction per line: start and
+    end time and engine wait in microseconds, ~ if the start of the
+    transaction was lost, then the bytes in hex, with C or D wherever the D/C
+    line changes. If earlier transactions were dropped, a first line marked =
+    restores the remap setting they left. parse() reads it back.
+    @param   p  Where to print, e.g. Serial
+    @return  Number of characters printed
+*/
+/**************************************************************************/
+size_t SSD1331_TraceRecorder::printTo(Print &p) const {
+  size_t n = p.print("# SSD1331 trace, ");
+  n += p.print(count);
+  n += p.print(" transactions, ");
+  n += p.print(lost);
+  n += p.println(" dropped");
+
+  SSD1331_TraceEntry e;
+  if (baseRemap >= 0 && get(0, e)) {
+    n += p.print(e.start);
+    n += p.print(' ');
+    n += p.print(e.start);
+    n += p.print(" 0 = C");
+    n += printHex(p, SSD1331_CMD_SETREMAP);
+    n += printHex(p, baseRemap);
+    n += p.println();
+  }
+
+  for (uint16_t i = 0; get(i, e); i++) {
+    n += p.print(e.start);
+    n += p.print(' ');
+    n += p.print(e.end);
+    n += p.print(' ');
+    n += p.print(e.waitUs);
+    if (e.flags & SSD1331_TRACE_TRUNCATED)
+      n += p.print(" ~");
+    for (uint16_t j = 0; j < e.length; j++) {
+      bool data, wasData = false;
+      uint8_t b = getByte(e, j, data);
+      if (j)
+        getByte(e, j - 1, wasData);
+      if (!j || data != wasData)
+        n += p.print(data ? " D" : " C");
+      n += printHex(p, b);
+    }
+    n += p.println();
+  }
+  return n;
+}
+
+// Handles a whitespace-separated token of parse() input
+void SSD1331_TraceRecorder::token(void) {
+  if (!tokLen)
+    return;
+  tok[tokLen] = 0;
+  tokLen = 0;
+
+  char *end;
+  unsigned long v = strtoul(tok, &end, field < 3 ? 10 : 16);
+  switch (field) {
+  case 0:
+    parseStart = v;
+    field++;
+    return;
+  case 1:
+    parseEnd = v;
+    field++;
+    return;
+  case 2:
+    newEntry(parseStart);
+    if (count) {
+      newest().end = parseEnd;
+      newest().waitUs = v > 0xFFFF ? 0xFFFF : v;
+    }
+    parseData = true;
+    field++;
+    return;
+  }
+  if (!strcmp(tok, "C")) {
+    parseData = false;
+  } else if (!strcmp(tok, "D")) {
+    parseData = true;
+  } else if (!strcmp(tok, "~")) {
+    if (count)
+      newest().flags |= SSD1331_TRACE_TRUNCATED;
+  } else if (*end == 0 && v <= 0xFF) {
+    // "=" lines need nothing special, they replay like any other
+    addByte(v, parseData);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read a trace printed by printTo() a character at a time, e.g.
+    straight from Serial, to load a trace dumped from a customer's device.
+    Transactions are added to the trace, so clear() it first and detach it
+    from the display. Comment lines start with #.
+    @param  c  The next character
+*/
+/**************************************************************************/
+void SSD1331_TraceRecorder::parse(char c) {
+  if (comment) {
+    comment = c != '\n';
+    return;
+  }
+  if (c == '#' && !field && !tokLen) {
+    comment = true;
+  } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+    token();
+    if (c == '\n') {
+      // A transaction read from text is already finished
+      if (field == 3)
+        open = false;
+      field = 0;
+    }
+  } else if (tokLen < sizeof(tok) - 1) {
+    tok[tokLen++] = c;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read lines of a trace printed by printTo(). A last line without
+    a newline is read too.
+    @param  text  The text, NUL-terminated
+*/
+/**************************************************************************/
+void SSD1331_TraceRecorder::parse(const char *text) {
+  while (*text)
+    parse(*text++);
+  if (field || tokLen || comment)
+    parse('\n');
+}
+
+/**************************************************************************/
+/*!
+    @brief  Feed the trace, oldest transaction first, to another tap.
+    Replaying into an SSD1331_Emulator shows what the panel was sent. If
+    transactions were dropped, the remap setting they left is restored first,
+    though the rest of the panel's state (such as the address window) is
+    only known once the trace sets it again.
+    @param  target  The tap to feed
+*/
+/**************************************************************************/
+void SSD1331_TraceRecorder::replay(SSD1331_BusTap &target) const {
+  if (baseRemap >= 0) {
+    target.busBegin();
+    target.busWrite(SSD1331_CMD_SETREMAP, false);
+    target.busWrite(baseRemap, false);
+    target.busEnd();
+  }
+  SSD1331_TraceEntry e;
+  for (uint16_t i = 0; get(i, e); i++) {
+    target.busBegin();
+    for (uint16_t j = 0; j < e.length; j++) {
+      bool data;
+      uint8_t b = getByte(e, j, data);
+      target.busWrite(b, data);
+    }
+    if (e.waitUs)
+      target.busDelay(e.waitUs);
+    target.busEnd();
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief   List the places where the bus sat idle for longer than expected,
+    i.e. where the time from the end of one transaction to the start of the
+    next is at least minGapUs. These show where the sketch or an interrupt
+    held up drawing.
+    @param   p         Where to print, e.g. Serial
+    @param   minGapUs  Smallest gap to report, in microseconds
+    @return  Number of characters printed
+*/
+/**************************************************************************/
+size_t SSD1331_TraceRecorder::printGaps(Print &p, uint32_t minGapUs) const {
+  size_t n = 0;
+  uint32_t total = 0;
+  SSD1331_TraceEntry prev, e;
+  for (uint16_t i = 1; get(i - 1, prev) && get(i, e); i++) {
+    uint32_t gap = e.start - prev.end;
+    if ((int32_t)gap < 0 || gap < minGapUs)
+      continue;
+    total += gap;
+    n += p.print("gap ");
+    n += p.print(gap);
+    n += p.print(" us before transaction ");
+    n += p.print(i);
+    n += p.print(" at ");
+    n += p.println(e.start);
+  }
+  n += p.print("total ");
+  n += p.print(total);
+  n += p.println(" us");
+  return n;
+}
+
+#endif // SSD1331_BUS_TAP
@@ -0,0 +1,105 @@
+/*!
+ * @file Adafruit_SSD1331_Trace.h
+ *
+ * Keeps a timestamped trace of the last SPI transactions the SSD1331 driver
+ * made, in a ring buffer, so there's a record of what led up to a corrupted
+ * display. A trace can be dumped as text, read back in, and replayed into
+ * another tap (such as SSD1331_Emulator or SSD1331_TimingModel) to see what
+ * the panel made of it, or to use as a workload when testing driver
+ * changes. Requires SSD1331_BUS_TAP to be defined in Adafruit_SSD1331.h.
+ */
+
+#ifndef _ADAFRUIT_SSD1331_TRACE_H_
+#define _ADAFRUIT_SSD1331_TRACE_H_
+
+#include "Adafruit_SSD1331.h"
+
+#ifdef SSD1331_BUS_TAP
+
+/*!
+ * @brief Flags of a trace entry
+ */
+enum {
+  SSD1331_TRACE_TRUNCATED = 0x01 ///< The start of the transaction was lost
+};
+
+/// One SPI transaction of a bus trace
+struct SSD1331_TraceEntry {
+  uint32_t start;  ///< micros() when the transaction began
+  uint32_t end;    ///< micros() when it ended
+  uint16_t first;  ///< Where its bytes start in the recorder's byte ring
+  uint16_t length; ///< Number of bytes held, see getByte()
+  uint16_t waitUs; ///< Time spent waiting for the drawing engine
+  uint8_t flags;   ///< SSD1331_TRACE_*
+};
+
+/// A bus tap that keeps the last transactions it saw in a ring buffer
+class SSD1331_TraceRecorder : public SSD1331_BusTap {
+public:
+  SSD1331_TraceRecorder(uint16_t transactions = 32, uint16_t bytes = 512);
+  ~SSD1331_TraceRecorder(void);
+
+  void busBegin(void);
+  void busWrite(uint8_t b, bool data);
+  void busDelay(uint16_t us);
+  void busEnd(void);
+
+  void clear(void);
+  bool get(uint16_t i, SSD1331_TraceEntry &e) const;
+  uint8_t getByte(const SSD1331_TraceEntry &e, uint16_t i, bool &data) const;
+  void parse(char c);
+  void parse(const char *text);
+
+  size_t printTo(Print &p) const;
+  void replay(SSD1331_BusTap &target) const;
+  size_t printGaps(Print &p, uint32_t minGapUs) const;
+
+  /*!
+    @brief   Get the number of transactions held
+    @return  Entries, oldest first, that get() can return
+  */
+  uint16_t size(void) const { return count; }
+  /*!
+    @brief   Get the number of transactions lost since the last clear()
+    @return  Entries dropped off the start of the trace
+  */
+  uint32_t dropped(void) const { return lost; }
+
+private:
+  void newEntry(uint32_t start);
+  void addByte(uint8_t b, bool data);
+  void dropOldest(void);
+  void forget(uint16_t at);
+  void token(void);
+  SSD1331_TraceEntry &oldest(void) {
+    return entries[(head + maxEntries - count) % maxEntries];
+  }
+  SSD1331_TraceEntry &newest(void) {
+    return entries[(head + maxEntries - 1) % maxEntries];
+  }
+
+  SSD1331_TraceEntry *entries;
+  uint16_t maxEntries, head, count; // Transaction ring
+  uint8_t *bytes;   // Byte ring, shared by the transactions in order
+  uint8_t *dcBits;  // D/C state of each byte, 1 bit per byte
+  uint16_t maxBytes, byteHead, byteCount;
+  uint32_t lost;
+  bool open; // Bytes go to the newest entry until busEnd()
+
+  // The SETREMAP setting in effect before the oldest byte held, or -1 if
+  // the trace still holds everything since it was cleared. Replaying
+  // starts by restoring it, so the panel model decodes the rest right.
+  int16_t baseRemap;
+  bool remapNext; // The last byte dropped was a SETREMAP command
+
+  // parse() state
+  char tok[12];
+  uint8_t tokLen;
+  uint8_t field; // 0-2: times and wait, 3: bytes
+  bool parseData, comment;
+  uint32_t parseStart, parseEnd;
+};
+
+#endif // SSD1331_BUS_TAP
+
+#endif // _ADAFRUIT_SSD1331_TRACE_H_
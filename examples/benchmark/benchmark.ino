@@ -0,0 +1,186 @@
+/*
+ * Times each drawing primitive over many calls and prints microseconds per
+ * call and pixels per second, so that runs on different boards, SPI clocks
+ * or library versions can be compared.
+ *
+ * Output is one CSV line per primitive and rotation:
+ *   bench,<primitive>,<rotation>,<calls>,<us per call>,<pixels per second>
+ * with lines starting with '#' giving the board setup. For comparison with
+ * the display's drawing engine, "_sw" primitives are drawn pixel by pixel
+ * and "rect_lines" is drawn as four separate lines.
+ *
+ * BSD license.
+ */
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1331.h>
+#include <SPI.h>
+
+#define sclk 13
+#define mosi 11
+#define cs   10
+#define rst  9
+#define dc   8
+
+// SPI clock to run the display at
+#define SPI_FREQ 8000000
+
+// Calls timed per primitive
+#define CALLS 100
+
+Adafruit_SSD1331 display = Adafruit_SSD1331(&SPI, cs, dc, rst);
+
+uint16_t bitmap[16 * 16];
+
+// Each test draws call i of CALLS, and returns the pixels it drew.
+typedef uint32_t (*Test)(uint16_t i);
+
+uint16_t color(uint16_t i) { return i * 0x0841 + 0x1234; }
+
+uint32_t testPixel(uint16_t i) {
+  display.drawPixel(i % display.width(), (i / display.width()) % 8,
+                    color(i));
+  return 1;
+}
+
+uint32_t testHLine(uint16_t i) {
+  display.drawFastHLine(0, i % display.height(), display.width(), color(i));
+  return display.width();
+}
+
+uint32_t testVLine(uint16_t i) {
+  display.drawFastVLine(i % display.width(), 0, display.height(), color(i));
+  return display.height();
+}
+
+uint32_t testLine(uint16_t i) {
+  int16_t w = display.width(), h = display.height();
+  display.drawLine(0, 0, w - 1, h - 1 - i % h, color(i));
+  return max(w, (int16_t)(h - i % h));
+}
+
+uint32_t testLineSw(uint16_t i) {
+  int16_t w = display.width(), h = display.height();
+  display.startWrite();
+  display.Adafruit_GFX::writeLine(0, 0, w - 1, h - 1 - i % h, color(i));
+  display.endWrite();
+  return max(w, (int16_t)(h - i % h));
+}
+
+uint32_t testRect(uint16_t i) {
+  display.drawRect(i % 16, i % 16, 32, 24, color(i));
+  return 2 * (32 + 24) - 4;
+}
+
+uint32_t testRectLines(uint16_t i) {
+  display.Adafruit_GFX::drawRect(i % 16, i % 16, 32, 24, color(i));
+  return 2 * (32 + 24) - 4;
+}
+
+uint32_t testFill(uint16_t i) {
+  display.fillRect(i % 16, i % 16, 32, 24, color(i));
+  return 32 * 24;
+}
+
+uint32_t testFillSw(uint16_t i) {
+  // Streams every pixel through an address window
+  display.startWrite();
+  display.setAddrWindow(i % 16, i % 16, 32, 24);
+  display.writeColor(color(i), 32 * 24);
+  display.endWrite();
+  return 32 * 24;
+}
+
+uint32_t testClear(uint16_t i) {
+  display.fillScreen(0);
+  return (uint32_t)display.width() * display.height();
+}
+
+#ifdef SSD1331_EXTRAS
+uint32_t testCopy(uint16_t i) {
+  display.copyBits(0, 0, 32, 24, 32 + i % 16, 24 + i % 16);
+  return 32 * 24;
+}
+#endif
+
+uint32_t testText(uint16_t i) {
+  display.setCursor(i % 8, i % 32);
+  display.print("Bench");
+  return 5 * 6 * 8;
+}
+
+uint32_t testBitmap(uint16_t i) {
+  display.drawRGBBitmap(i % 64, i % 32, bitmap, 16, 16);
+  return 16 * 16;
+}
+
+struct {
+  const char *name;
+  Test test;
+} const tests[] = {
+  {"pixel", testPixel},
+  {"hline", testHLine},
+  {"vline", testVLine},
+  {"line", testLine},
+  {"line_sw", testLineSw},
+  {"rect", testRect},
+  {"rect_lines", testRectLines},
+  {"fill", testFill},
+  {"fill_sw", testFillSw},
+  {"clear", testClear},
+#ifdef SSD1331_EXTRAS
+  {"copy", testCopy},
+#endif
+  {"text", testText},
+  {"bitmap", testBitmap},
+};
+
+void run(uint8_t t, uint8_t rotation) {
+  display.fillScreen(0);
+  uint32_t pixels = 0;
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < CALLS; i++)
+    pixels += tests[t].test(i);
+  uint32_t us = micros() - start;
+
+  Serial.print("bench,");
+  Serial.print(tests[t].name);
+  Serial.print(',');
+  Serial.print(rotation);
+  Serial.print(',');
+  Serial.print(CALLS);
+  Serial.print(',');
+  Serial.print((float)us / CALLS, 2);
+  Serial.print(',');
+  Serial.println(us ? (uint32_t)((float)pixels * 1000000.0 / us) : 0);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+
+  display.begin(SPI_FREQ);
+  display.setTextColor(0xFFFF, 0x001F);
+  for (uint16_t i = 0; i < 16 * 16; i++)
+    bitmap[i] = color(i);
+
+  Serial.println("# SSD1331 benchmark");
+#ifdef F_CPU
+  Serial.print("# cpu_hz,");
+  Serial.println((uint32_t)F_CPU);
+#endif
+  Serial.print("# spi_hz,");
+  Serial.println((uint32_t)SPI_FREQ);
+  Serial.println("# bench,primitive,rotation,calls,us_per_call,pixels_per_s");
+
+  for (uint8_t r = 0; r < 4; r++) {
+    display.setRotation(r);
+    for (uint8_t t = 0; t < sizeof(tests) / sizeof(tests[0]); t++)
+      run(t, r);
+  }
+  display.setRotation(0);
+  Serial.println("# done");
+}
+
+void loop() {}
@@ -0,0 +1,283 @@
+/*
+ * Fuzz test for the driver's clipping and drawing engine fast paths.
+ *
+ * Calls every drawing entry point with random positions, sizes, colors and
+ * rotations, many of them partly or entirely off screen. Each call is made
+ * both on the display, offline with an SSD1331_Emulator attached, and on a
+ * GFXcanvas16 that serves as the software reference. After each call, the
+ * emulated display RAM must match the canvas pixel for pixel. On the first
+ * difference the sketch prints the call and the pixel and stops; the seed
+ * makes a failing run repeatable.
+ *
+ * Diagonal lines are the exception. The driver draws them with the drawing
+ * engine, and the emulator rasterizes those in its own way, as the panel's
+ * rounding isn't documented, so a pixel of such a line may be one pixel
+ * away from where Adafruit_GFX puts it. After a line the canvas is brought
+ * into line with the emulator, so later calls are compared exactly.
+ *
+ * Needs SSD1331_BUS_TAP to be defined in Adafruit_SSD1331.h, and about 25KB
+ * of RAM, so use a board like an ESP32 or SAMD51.
+ *
+ * BSD license.
+ */
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_Emulator.h>
+#include <SPI.h>
+
+#define cs   10
+#define rst  9
+#define dc   8
+
+// Change to explore other sequences, or set to a failing seed to repeat it
+#define SEED 1
+
+// Calls to make. 0 runs until a difference is found.
+#ifndef CALLS
+#define CALLS 100000UL
+#endif
+
+#ifdef SSD1331_BUS_TAP
+Adafruit_SSD1331 display = Adafruit_SSD1331(cs, dc, rst);
+SSD1331_Emulator emulator;
+GFXcanvas16 canvas(Adafruit_SSD1331::TFTWIDTH, Adafruit_SSD1331::TFTHEIGHT);
+
+uint32_t state = SEED;
+uint16_t bitmap[16 * 16];
+
+// xorshift32, so runs repeat the same way on every board
+uint32_t next() {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// A number from lo to hi inclusive
+int16_t pick(int16_t lo, int16_t hi) { return lo + next() % (hi - lo + 1); }
+
+// A coordinate, often off screen
+int16_t coord(int16_t size) { return pick(-size / 2, size + size / 2); }
+
+enum {
+  OP_FILL,
+  OP_CLEAR,
+  OP_RECT,
+  OP_LINE,
+  OP_HLINE,
+  OP_VLINE,
+  OP_PIXEL,
+  OP_PIXELRUN,
+  OP_BITMAP,
+  OP_COPY,
+  OP_COUNT
+};
+
+const char *const opNames[] = {"fillRect",   "fillRect(black)", "drawRect",
+                               "drawLine",   "drawFastHLine",
+                               "drawFastVLine", "drawPixel", "writePixel run",
+                               "drawRGBBitmap", "copyBits"};
+
+// Copies like the drawing engine: only where both the source and the
+// destination pixel are on screen.
+void canvasCopy(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx,
+                int16_t dy, bool invert) {
+  static uint16_t copy[Adafruit_SSD1331::TFTWIDTH * Adafruit_SSD1331::TFTHEIGHT];
+  int16_t cw = canvas.width(), ch = canvas.height();
+  for (int16_t j = 0; j < ch; j++)
+    for (int16_t i = 0; i < cw; i++)
+      copy[j * cw + i] = canvas.getPixel(i, j);
+  for (int16_t j = 0; j < h; j++) {
+    for (int16_t i = 0; i < w; i++) {
+      int16_t sx = x + i, sy = y + j, tx = dx + i, ty = dy + j;
+      if (sx < 0 || sy < 0 || sx >= cw || sy >= ch || tx < 0 || ty < 0 ||
+          tx >= cw || ty >= ch)
+        continue;
+      uint16_t c = copy[sy * cw + sx];
+      canvas.drawPixel(tx, ty, invert ? ~c : c);
+    }
+  }
+}
+
+// Pixel of the emulated display RAM at screen coordinates. The driver
+// addresses RAM in screen coordinates, with x and y swapped in rotations
+// 1 and 3, and leaves mirroring to the display's remap setting.
+uint16_t ramPixel(int16_t x, int16_t y) {
+  const uint16_t *ram = emulator.getBuffer();
+  if (display.getRotation() & 1)
+    return ram[x * Adafruit_SSD1331::TFTWIDTH + y];
+  return ram[y * Adafruit_SSD1331::TFTWIDTH + x];
+}
+
+// Whether a pixel of the given color is at or next to (x, y), in the
+// emulated RAM or the canvas
+bool near(int16_t x, int16_t y, uint16_t color, bool ram) {
+  for (int16_t j = y - 1; j <= y + 1; j++) {
+    for (int16_t i = x - 1; i <= x + 1; i++) {
+      if (i < 0 || j < 0 || i >= canvas.width() || j >= canvas.height())
+        continue;
+      if ((ram ? ramPixel(i, j) : canvas.getPixel(i, j)) == color)
+        return true;
+    }
+  }
+  return false;
+}
+
+// Makes one random call on both. Returns the arguments for reporting.
+uint8_t call(int16_t *a) {
+  int16_t w = display.width(), h = display.height();
+  uint8_t op = next() % OP_COUNT;
+  a[0] = coord(w);
+  a[1] = coord(h);
+  a[2] = pick(1, w + 8);
+  a[3] = pick(1, h + 8);
+  a[4] = next();
+
+  switch (op) {
+  case OP_FILL:
+  case OP_CLEAR:
+    if (op == OP_CLEAR)
+      a[4] = 0;
+    display.fillRect(a[0], a[1], a[2], a[3], a[4]);
+    canvas.fillRect(a[0], a[1], a[2], a[3], a[4]);
+    break;
+  case OP_RECT:
+    display.drawRect(a[0], a[1], a[2], a[3], a[4]);
+    canvas.drawRect(a[0], a[1], a[2], a[3], a[4]);
+    break;
+  case OP_LINE:
+    a[2] = coord(w);
+    a[3] = coord(h);
+    display.drawLine(a[0], a[1], a[2], a[3], a[4]);
+    canvas.drawLine(a[0], a[1], a[2], a[3], a[4]);
+    break;
+  case OP_HLINE:
+    display.drawFastHLine(a[0], a[1], a[2], a[4]);
+    canvas.drawFastHLine(a[0], a[1], a[2], a[4]);
+    break;
+  case OP_VLINE:
+    display.drawFastVLine(a[0], a[1], a[3], a[4]);
+    canvas.drawFastVLine(a[0], a[1], a[3], a[4]);
+    break;
+  case OP_PIXEL:
+    display.drawPixel(a[0], a[1], a[4]);
+    canvas.drawPixel(a[0], a[1], a[4]);
+    break;
+  case OP_PIXELRUN:
+    // Consecutive pixels, which the driver sends through one window
+    display.startWrite();
+    for (int16_t i = 0; i < a[2]; i++)
+      display.writePixel(a[0] + i, a[1], a[4] + i);
+    display.endWrite();
+    for (int16_t i = 0; i < a[2]; i++)
+      canvas.drawPixel(a[0] + i, a[1], a[4] + i);
+    break;
+  case OP_BITMAP:
+    a[2] = pick(1, 16);
+    a[3] = pick(1, 16);
+    for (uint16_t i = 0; i < 16 * 16; i++)
+      bitmap[i] = next();
+    display.drawRGBBitmap(a[0], a[1], bitmap, a[2], a[3]);
+    canvas.drawRGBBitmap(a[0], a[1], bitmap, a[2], a[3]);
+    break;
+  case OP_COPY:
+#ifdef SSD1331_EXTRAS
+    a[5] = coord(w);
+    a[6] = coord(h);
+    a[4] &= 1;
+    display.copyBits(a[0], a[1], a[2], a[3], a[5], a[6], a[4]);
+    canvasCopy(a[0], a[1], a[2], a[3], a[5], a[6], a[4]);
+#endif
+    break;
+  }
+  return op;
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+  if (!emulator.getBuffer() || !canvas.getBuffer()) {
+    Serial.println("Not enough RAM");
+    return;
+  }
+
+  display.setBusTap(&emulator, true);
+  display.begin();
+  canvas.fillScreen(0);
+
+  Serial.print("Seed ");
+  Serial.println(SEED);
+  for (uint32_t n = 0; !CALLS || n < CALLS; n++) {
+    if (!(n % 64)) {
+      // Clear on rotating, as ramPixel() only maps RAM drawn in the
+      // current rotation
+      uint8_t r = next() & 3;
+      display.setRotation(r);
+      canvas.setRotation(display.getRotation()); // May be fixed
+
+      display.fillScreen(0);
+      canvas.fillScreen(0);
+    }
+
+    int16_t a[7] = {0};
+    uint8_t op = call(a);
+
+    for (int16_t y = 0; y < canvas.height(); y++) {
+      for (int16_t x = 0; x < canvas.width(); x++) {
+        uint16_t want = canvas.getPixel(x, y), got = ramPixel(x, y);
+        if (want == got)
+          continue;
+        // A line pixel the other side drew one pixel away
+        uint16_t line = a[4];
+        if (op == OP_LINE && ((got == line && near(x, y, line, false)) ||
+                              (want == line && near(x, y, line, true))))
+          continue;
+        Serial.print("FAIL at call ");
+        Serial.print(n);
+        Serial.print(", rotation ");
+        Serial.print(display.getRotation());
+        Serial.print(": ");
+        Serial.print(opNames[op]);
+        for (uint8_t i = 0; i < 7; i++) {
+          Serial.print(i ? ", " : "(");
+          Serial.print(a[i]);
+        }
+        Serial.println(")");
+        Serial.print("Pixel (");
+        Serial.print(x);
+        Serial.print(", ");
+        Serial.print(y);
+        Serial.print(") is 0x");
+        Serial.print(got, HEX);
+        Serial.print(", expected 0x");
+        Serial.println(want, HEX);
+        return;
+      }
+    }
+    if (op == OP_LINE) {
+      for (int16_t y = 0; y < canvas.height(); y++)
+        for (int16_t x = 0; x < canvas.width(); x++)
+          canvas.drawPixel(x, y, ramPixel(x, y));
+    }
+    if (!(n % 1000)) {
+      Serial.print(n);
+      Serial.println(" calls OK");
+    }
+  }
+  Serial.println("PASS");
+}
+
+void loop() {}
+
+#else
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+  Serial.println("Define SSD1331_BUS_TAP in Adafruit_SSD1331.h to run this");
+}
+
+void loop() {}
+#endif // SSD1331_BUS_TAP
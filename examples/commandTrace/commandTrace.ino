@@ -0,0 +1,119 @@
+/*
+ * Keeps a trace of what was last sent to the display, and replays traces
+ * into the emulator.
+ *
+ * The sketch draws with an SSD1331_TraceRecorder attached from before
+ * begin(), which holds the last few dozen SPI transactions, with their
+ * timestamps. Over Serial:
+ *   d  dumps the trace as text
+ *   r  replays the trace into the emulator, then prints its image checksum
+ *      and the gaps where the bus sat idle
+ *   p  prints the emulator's image as a PPM file
+ * Lines of a dumped trace sent back over Serial (from this or another
+ * device) replace the trace, so a customer's trace can be replayed here.
+ *
+ * Needs SSD1331_BUS_TAP to be defined in Adafruit_SSD1331.h, and about 16KB
+ * of RAM, so use a board like a SAMD21 or ESP32. A dump can also be replayed
+ * on a PC with extras/host/tools/trace_replay.
+ *
+ * BSD license.
+ */
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_Emulator.h>
+#include <Adafruit_SSD1331_Trace.h>
+#include <SPI.h>
+
+#define sclk 13
+#define mosi 11
+#define cs   10
+#define rst  9
+#define dc   8
+
+#ifdef SSD1331_BUS_TAP
+Adafruit_SSD1331 display = Adafruit_SSD1331(cs, dc, rst);
+SSD1331_TraceRecorder trace(64, 2048);
+SSD1331_Emulator emulator;
+
+char command = 0;     // Command on the current line, if it's not a trace
+uint8_t lineLen = 0;
+bool inTrace = false; // The current line is part of a trace
+bool loaded = false;  // Set once a trace has been read from Serial
+
+void setup() {
+  Serial.begin(115200);
+  // Attach first, so the trace starts with the panel's setup
+  display.setBusTap(&trace);
+  display.begin();
+  display.fillScreen(0);
+}
+
+void replay() {
+  emulator.reset();
+  trace.replay(emulator);
+  Serial.print("Image CRC: 0x");
+  Serial.println(emulator.crc32(), HEX);
+  trace.printGaps(Serial, 100);
+}
+
+void readSerial() {
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (!lineLen && ((c >= '0' && c <= '9') || c == '#')) {
+      // Trace lines can be longer than any buffer here, so stream them
+      inTrace = true;
+      if (!loaded) {
+        // Stop recording so the trace being loaded isn't mixed with drawing
+        display.setBusTap(NULL);
+        trace.clear();
+        loaded = true;
+      }
+    }
+    if (inTrace)
+      trace.parse(c);
+    if (c != '\n' && c != '\r') {
+      command = lineLen ? 0 : c;
+      if (lineLen < 2)
+        lineLen++;
+      continue;
+    }
+    if (!inTrace && lineLen == 1) {
+      if (command == 'd')
+        trace.printTo(Serial);
+      else if (command == 'r')
+        replay();
+      else if (command == 'p')
+        emulator.printPPM(Serial);
+    }
+    lineLen = 0;
+    inTrace = false;
+  }
+}
+
+void loop() {
+  readSerial();
+  if (loaded)
+    return;
+
+  int16_t x = random(display.width() - 10);
+  int16_t y = random(display.height() - 10);
+  display.fillRect(x, y, 10, 10, random(0x10000));
+  display.drawLine(random(display.width()), random(display.height()),
+                   random(display.width()), random(display.height()),
+                   random(0x10000));
+  display.drawPixel(random(display.width()), random(display.height()),
+                    0xFFFF);
+  delay(50);
+}
+
+#else
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+  Serial.println("Define SSD1331_BUS_TAP in Adafruit_SSD1331.h to run this");
+}
+
+void loop() {}
+#endif // SSD1331_BUS_TAP
@@ -0,0 +1,188 @@
+/*
+ * Measures the CPU time of the driver's drawing paths with the bus taken
+ * out of the picture.
+ *
+ * On a real display, SPI time hides how long the driver itself spends on
+ * clipping, coordinate swapping, color conversion and so on. Here the
+ * display runs offline behind a bus tap that throws bytes away, so what's
+ * left is the CPU cost, plus one virtual call per byte for the tap. Each
+ * benchmark repeats until it has run for at least MIN_TIME_US, and prints
+ * a line in the style of Google Benchmark:
+ *   <name> <ns per call> ns <iterations>
+ * so runs from different library versions can be compared on one board.
+ *
+ * The tap isn't free, and on a fast board its calls can outweigh what is
+ * being measured. extras/host/bench/cpu.cpp runs the same cases on a PC
+ * with Google Benchmark, built without the tap, for a bus that really does
+ * nothing; `make -C extras/host bench` builds and runs it.
+ *
+ * Needs SSD1331_BUS_TAP to be defined in Adafruit_SSD1331.h.
+ *
+ * BSD license.
+ */
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1331.h>
+#include <SPI.h>
+
+#define cs   10
+#define rst  9
+#define dc   8
+
+// Shortest time to run each benchmark for
+#define MIN_TIME_US 200000UL
+
+#ifdef SSD1331_BUS_TAP
+Adafruit_SSD1331 display = Adafruit_SSD1331(cs, dc, rst);
+
+// Discards every byte, so drawing costs no bus time
+class NullTap : public SSD1331_BusTap {
+public:
+  void busWrite(uint8_t b, bool data) {}
+} nullTap;
+
+uint16_t pixels[64];
+volatile uint8_t sink; // Keeps results of pure functions from being dropped
+
+typedef void (*Bench)(uint32_t i);
+
+void benchPixel(uint32_t i) { display.drawPixel(i % 96, (i / 96) % 64, i); }
+
+void benchPixelRun(uint32_t i) {
+  display.startWrite();
+  for (int16_t x = 0; x < 32; x++)
+    display.writePixel(x, i % 64, i);
+  display.endWrite();
+}
+
+void benchFill(uint32_t i) { display.fillRect(i % 16, 8, 32, 24, i | 1); }
+
+void benchFillClipped(uint32_t i) {
+  display.fillRect(-16 + (int16_t)(i % 8), -8, 48, 24, i | 1);
+}
+
+void benchClear(uint32_t i) { display.fillRect(0, 0, 96, 64, 0); }
+
+void benchLine(uint32_t i) { display.drawLine(0, 0, 95, i % 64, i); }
+
+void benchLineClipped(uint32_t i) {
+  display.drawLine(-20, -10, 95, i % 64, i);
+}
+
+void benchHLine(uint32_t i) { display.drawFastHLine(0, i % 64, 96, i); }
+
+void benchRect(uint32_t i) { display.drawRect(i % 16, 8, 32, 24, i); }
+
+void benchRectClipped(uint32_t i) { display.drawRect(-8, -8, 32, 24, i); }
+
+void benchWindow(uint32_t i) {
+  display.startWrite();
+  display.setAddrWindow(i % 32, 8, 32, 24);
+  display.endWrite();
+}
+
+void benchWritePixels(uint32_t i) {
+  display.startWrite();
+  display.setAddrWindow(0, 0, 64, 1);
+  display.writePixels(pixels, 64);
+  display.endWrite();
+}
+
+void benchWriteColor(uint32_t i) {
+  display.startWrite();
+  display.setAddrWindow(0, 0, 64, 1);
+  display.writeColor(i, 64);
+  display.endWrite();
+}
+
+void benchWriteColorDither(uint32_t i) {
+  display.setColorDepth(SSD1331_COLORDEPTH_256, true);
+  benchWriteColor(i);
+  display.setColorDepth(SSD1331_COLORDEPTH_65K);
+}
+
+void benchColor332(uint32_t i) {
+  sink += Adafruit_SSD1331::color332(i);
+}
+
+void benchBitmap(uint32_t i) {
+  display.drawRGBBitmap(i % 32, 8, pixels, 8, 8);
+}
+
+void benchChar(uint32_t i) {
+  display.drawChar(i % 64, 8, 'A' + i % 26, 0xFFFF, 0x001F, 1);
+}
+
+void benchRotation(uint32_t i) { display.setRotation(i & 3); }
+
+struct {
+  const char *name;
+  Bench bench;
+} const benches[] = {
+  {"BM_drawPixel", benchPixel},
+  {"BM_writePixel/run32", benchPixelRun},
+  {"BM_fillRect", benchFill},
+  {"BM_fillRect/clipped", benchFillClipped},
+  {"BM_fillRect/clear", benchClear},
+  {"BM_drawLine", benchLine},
+  {"BM_drawLine/clipped", benchLineClipped},
+  {"BM_drawFastHLine", benchHLine},
+  {"BM_drawRect", benchRect},
+  {"BM_drawRect/clipped", benchRectClipped},
+  {"BM_setAddrWindow", benchWindow},
+  {"BM_writePixels/64", benchWritePixels},
+  {"BM_writeColor/64", benchWriteColor},
+  {"BM_writeColor/64/dither332", benchWriteColorDither},
+  {"BM_color332", benchColor332},
+  {"BM_drawRGBBitmap/8x8", benchBitmap},
+  {"BM_drawChar", benchChar},
+  {"BM_setRotation", benchRotation},
+};
+
+void run(const char *name, Bench bench) {
+  // Double the iterations until the run is long enough to time
+  uint32_t n = 1, us;
+  for (;;) {
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < n; i++)
+      bench(i);
+    us = micros() - start;
+    if (us >= MIN_TIME_US || n >= 0x40000000UL)
+      break;
+    n *= 2;
+  }
+  display.setRotation(0);
+
+  char line[64];
+  snprintf(line, sizeof(line), "%-28s %10lu ns %10lu", name,
+           (unsigned long)((uint64_t)us * 1000 / n), (unsigned long)n);
+  Serial.println(line);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+
+  display.setBusTap(&nullTap, true);
+  display.begin();
+  for (uint8_t i = 0; i < 64; i++)
+    pixels[i] = i * 0x0421;
+
+  Serial.println("Benchmark                          Time    Iterations");
+  for (uint8_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++)
+    run(benches[b].name, benches[b].bench);
+}
+
+void loop() {}
+
+#else
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+  Serial.println("Define SSD1331_BUS_TAP in Adafruit_SSD1331.h to run this");
+}
+
+void loop() {}
+#endif // SSD1331_BUS_TAP
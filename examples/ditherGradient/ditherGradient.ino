@@ -0,0 +1,86 @@
+/*
+ * Shows a 24-bit gradient three ways: truncated, Bayer dithered and
+ * Floyd-Steinberg dithered, in bands from top to bottom.
+ *
+ * Rows are made on the fly and streamed through Adafruit_SSD1331_Dither,
+ * so no image buffer is needed. Every few seconds the display switches
+ * between 65k and 256 colors, where the difference is easiest to see.
+ *
+ * BSD license.
+ */
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_Dither.h>
+#include <SPI.h>
+
+#define cs   10
+#define rst  9
+#define dc   8
+
+Adafruit_SSD1331 display = Adafruit_SSD1331(cs, dc, rst);
+
+const int16_t W = Adafruit_SSD1331::TFTWIDTH;
+const int16_t BAND = Adafruit_SSD1331::TFTHEIGHT / 3;
+
+uint8_t rgb[W * 3];  // One source row, 24-bit
+uint16_t pixels[W];  // One converted row, RGB565 or RGB332
+
+// A slow dark-to-bright gradient, which bands badly when truncated
+void makeRow(int16_t y) {
+  for (int16_t x = 0; x < W; x++) {
+    rgb[x * 3] = x * 96 / W + y;      // red
+    rgb[x * 3 + 1] = x * 160 / W;     // green
+    rgb[x * 3 + 2] = 64 + x * 48 / W; // blue
+  }
+}
+
+void drawBand(uint8_t method, int16_t top) {
+  Adafruit_SSD1331_Dither dither(method);
+  uint8_t depth = display.getColorDepth();
+  if (!dither.begin(W, depth, 0, top))
+    return;
+
+  display.startWrite();
+  display.setAddrWindow(0, top, W, BAND);
+  for (int16_t y = 0; y < BAND; y++) {
+    makeRow(y);
+    dither.convertRow(rgb, pixels);
+    if (depth == SSD1331_COLORDEPTH_256)
+      display.writePixels332((uint8_t *)pixels, W);
+    else
+      display.writePixels(pixels, W);
+  }
+  display.endWrite();
+  dither.end();
+}
+
+void setup() {
+  Serial.begin(9600);
+  display.begin();
+}
+
+void loop() {
+  static bool depth256 = false;
+  display.setColorDepth(depth256 ? SSD1331_COLORDEPTH_256
+                                 : SSD1331_COLORDEPTH_65K);
+
+  uint32_t t = micros();
+  drawBand(SSD1331_DITHER_NONE, 0);
+  uint32_t none = micros();
+  drawBand(SSD1331_DITHER_BAYER, BAND);
+  uint32_t bayer = micros();
+  drawBand(SSD1331_DITHER_FLOYD, BAND * 2);
+  uint32_t floyd = micros();
+
+  Serial.print(depth256 ? "256 colors" : "65k colors");
+  Serial.print(", us per band: none ");
+  Serial.print(none - t);
+  Serial.print(", bayer ");
+  Serial.print(bayer - none);
+  Serial.print(", floyd ");
+  Serial.println(floyd - bayer);
+
+  depth256 = !depth256;
+  delay(3000);
+}
@@ -0,0 +1,80 @@
+/*
+ * Predicts the frame rate of a screen design before building it.
+ *
+ * The screen is described as the draw calls it makes each frame, and the
+ * timing model adds up the bytes, transactions and drawing engine waits
+ * they take. The sketch prints the estimated frame time and rate for a few
+ * SPI clocks and microcontrollers. No display is needed.
+ *
+ * With SSD1331_BUS_TAP defined in Adafruit_SSD1331.h, the frame is also
+ * drawn through the driver with the model attached as an offline tap, which
+ * counts exactly what the driver would send.
+ *
+ * BSD license.
+ */
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_Timing.h>
+#include <SPI.h>
+
+#define cs   10
+#define rst  9
+#define dc   8
+
+Adafruit_SSD1331 display = Adafruit_SSD1331(cs, dc, rst);
+SSD1331_TimingModel model;
+
+const uint32_t clocks[] = {4000000, 8000000, 16000000, 24000000};
+const SSD1331_McuProfile mcus[] = {SSD1331_MCU_AVR, SSD1331_MCU_SAMD21,
+                                   SSD1331_MCU_ESP32};
+
+// A dashboard: cleared background, three gauges (outline plus filled bar),
+// a 32x32 icon and a line of text with a background color.
+void describeFrame() {
+  model.addFill(96, 64, 0);
+  for (uint8_t i = 0; i < 3; i++) {
+    model.addRect();
+    model.addFill(28, 10, 0x07E0);
+  }
+  model.addPixels(32, 32);
+  for (uint8_t i = 0; i < 8; i++) // One window per character
+    model.addPixels(6, 8);
+}
+
+#ifdef SSD1331_BUS_TAP
+const uint16_t icon[32 * 32] PROGMEM = {0};
+
+void drawFrame() {
+  display.fillScreen(0);
+  for (uint8_t i = 0; i < 3; i++) {
+    display.drawRect(2, 2 + i * 12, 30, 12, 0xFFFF);
+    display.fillRect(3, 3 + i * 12, 28, 10, 0x07E0);
+  }
+  display.drawRGBBitmap(60, 0, icon, 32, 32);
+  display.setCursor(0, 56);
+  display.setTextColor(0xFFFF, 0x001F);
+  display.print("Speed 42");
+}
+#endif
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+
+  describeFrame();
+  Serial.println("# From the description");
+  model.printTable(Serial, clocks, 4, mcus, 3);
+
+#ifdef SSD1331_BUS_TAP
+  display.setBusTap(&model, true);
+  display.begin();
+  model.reset();
+  drawFrame();
+  Serial.println("# From the driver");
+  model.printTable(Serial, clocks, 4, mcus, 3);
+#endif
+}
+
+void loop() {}
@@ -0,0 +1,86 @@
+/*
+ * Checks drawing code against a golden image without looking at a panel.
+ *
+ * The SSD1331_Emulator decodes everything the driver sends into its own
+ * copy of the display RAM. This sketch draws a test scene with the display
+ * offline (bytes go only to the emulator), prints the bytes it took and a
+ * checksum of the resulting image, and compares that to a known good value.
+ * Send 'p' over Serial to get the image as a PPM file (capture it with a
+ * serial terminal that can log binary data).
+ *
+ * Needs SSD1331_BUS_TAP to be defined in Adafruit_SSD1331.h, and about 13KB
+ * of RAM for the emulator, so use a board like a SAMD21 or ESP32.
+ *
+ * BSD license.
+ */
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_Emulator.h>
+#include <SPI.h>
+
+#define sclk 13
+#define mosi 11
+#define cs   10
+#define rst  9
+#define dc   8
+
+#ifdef SSD1331_BUS_TAP
+Adafruit_SSD1331 display = Adafruit_SSD1331(cs, dc, rst);
+SSD1331_Emulator emulator;
+
+// CRC of the scene's image, the same as extras/host/golden/goldenImage.ppm.
+// When the scene changes, run "make goldens" in extras/host, check the new
+// PPM, and copy the CRC the host build prints here.
+const uint32_t GOLDEN_CRC = 0xC9904BF9;
+
+void drawScene() {
+  display.fillScreen(0x0841);
+  display.fillRect(5, 5, 20, 10, 0xF800);
+  display.drawRect(30, 45, 20, 10, 0xFFE0);
+  display.drawLine(0, 63, 95, 20, 0x07FF);
+  for (int16_t i = 0; i < 40; i++)
+    display.drawPixel(50 + i, 10, 0xF81F);
+  display.setCursor(4, 24);
+  display.setTextColor(0xFFFF);
+  display.print("Golden");
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+
+  display.setBusTap(&emulator, true);
+  display.begin();
+  emulator.resetCounters();
+  drawScene();
+
+  uint32_t crc = emulator.crc32();
+  Serial.print("Command bytes: ");
+  Serial.println(emulator.commandBytes());
+  Serial.print("Data bytes:    ");
+  Serial.println(emulator.dataBytes());
+  Serial.print("Engine waits:  ");
+  Serial.print(emulator.delayMicros());
+  Serial.println(" us");
+  Serial.print("Image CRC:     0x");
+  Serial.println(crc, HEX);
+  Serial.println(crc == GOLDEN_CRC ? "PASS" : "FAIL");
+}
+
+void loop() {
+  if (Serial.read() == 'p')
+    emulator.printPPM(Serial);
+}
+
+#else
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+  Serial.println("Define SSD1331_BUS_TAP in Adafruit_SSD1331.h to run this");
+}
+
+void loop() {}
+#endif // SSD1331_BUS_TAP
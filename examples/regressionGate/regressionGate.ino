@@ -0,0 +1,293 @@
+/*
+ * Performance regression gate based on bus byte counts.
+ *
+ * Bytes sent per scene don't vary from run to run the way timings do, so
+ * they make a good check that a library change hasn't made drawing slower.
+ * This sketch draws the scenes from the test and LCDGFXDemo examples with
+ * the display offline and a timing model attached, counting command bytes,
+ * data bytes and drawing engine waits per scene. It prints a table of the
+ * counts against the baseline below, and FAIL if any count grew by more
+ * than THRESHOLD_PERCENT.
+ *
+ * The counts don't depend on the board, so the baseline below comes from
+ * the host build in extras/host, whose test also fails if any count changes
+ * at all. When a change to the library moves them on purpose, paste the
+ * block the sketch prints over the baseline.
+ *
+ * Needs SSD1331_BUS_TAP to be defined in Adafruit_SSD1331.h.
+ *
+ * BSD license.
+ */
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_Timing.h>
+#include <SPI.h>
+
+#define cs   10
+#define rst  9
+#define dc   8
+
+// How much a count may grow before the gate fails
+#define THRESHOLD_PERCENT 2
+
+#define BLACK   0x0000
+#define BLUE    0x001F
+#define RED     0xF800
+#define GREEN   0x07E0
+#define YELLOW  0xFFE0
+#define WHITE   0xFFFF
+
+#ifdef SSD1331_BUS_TAP
+Adafruit_SSD1331 display = Adafruit_SSD1331(cs, dc, rst);
+SSD1331_TimingModel model;
+
+// Counts per scene and rotation, from the host build
+struct Counts {
+  uint32_t cmd, data, delay;
+};
+const Counts baseline[][2] = {
+  {{384, 12288, 0}, {576, 12288, 0}}, // pattern
+  {{437, 0, 1536}, {437, 0, 1536}}, // lines
+  {{261, 0, 1536}, {261, 0, 1536}}, // fastlines
+  {{135, 0, 1536}, {135, 0, 1536}}, // rects
+  {{265, 0, 5516}, {265, 0, 5516}}, // fillrects
+  {{17675, 4306, 1536}, {17675, 4306, 1536}}, // circles
+  {{1133, 256, 1536}, {1511, 382, 1536}}, // triangles
+  {{10085, 2880, 1536}, {10085, 2880, 1536}}, // roundrects
+  {{5928, 266, 2058}, {5993, 266, 2066}}, // text
+  {{746, 0, 2373}, {807, 0, 2047}}, // buttons
+  {{1013, 1848, 1536}, {677, 1232, 1536}}, // bitmaps
+};
+
+void scenePattern() {
+  static const uint16_t stripes[] = {BLACK, YELLOW, 0xF81F, RED,
+                                     0x07FF, GREEN, BLUE, WHITE};
+  int16_t stripe = display.width() / 8;
+  display.startWrite();
+  for (int16_t y = 0; y < display.height(); y++)
+    for (int16_t x = 0; x < display.width(); x++)
+      display.writePixel(x, y, stripes[min(x / stripe, 7)]);
+  display.endWrite();
+}
+
+void sceneLines() {
+  int16_t w = display.width() - 1, h = display.height() - 1;
+  display.fillScreen(BLACK);
+  for (int16_t x = 0; x < w; x += 6) {
+    display.drawLine(0, 0, x, h, YELLOW);
+    display.drawLine(w, h, x, 0, YELLOW);
+  }
+  for (int16_t y = 0; y < h; y += 6) {
+    display.drawLine(0, 0, w, y, YELLOW);
+    display.drawLine(w, h, 0, y, YELLOW);
+  }
+}
+
+void sceneFastLines() {
+  display.fillScreen(BLACK);
+  for (int16_t y = 0; y < display.height() - 1; y += 5)
+    display.drawFastHLine(0, y, display.width() - 1, RED);
+  for (int16_t x = 0; x < display.width() - 1; x += 5)
+    display.drawFastVLine(x, 0, display.height() - 1, BLUE);
+}
+
+void sceneRects() {
+  display.fillScreen(BLACK);
+  int16_t size = min(display.width(), display.height()) - 1;
+  int16_t cx = (display.width() - 1) / 2, cy = (display.height() - 1) / 2;
+  for (int16_t x = 0; x < size; x += 6)
+    display.drawRect(cx - x / 2, cy - x / 2, x, x, GREEN);
+}
+
+void sceneFillRects() {
+  display.fillScreen(BLACK);
+  int16_t size = min(display.width(), display.height()) - 1;
+  int16_t cx = (display.width() - 1) / 2, cy = (display.height() - 1) / 2;
+  for (int16_t x = size; x > 6; x -= 6) {
+    display.fillRect(cx - x / 2, cy - x / 2, x, x, YELLOW);
+    display.drawRect(cx - x / 2, cy - x / 2, x, x, 0xF81F);
+  }
+}
+
+void sceneCircles() {
+  display.fillScreen(BLACK);
+  for (int16_t x = 5; x < display.width() - 1; x += 10)
+    for (int16_t y = 5; y < display.height() - 1; y += 10)
+      display.fillCircle(x, y, 5, BLUE);
+  for (int16_t x = 0; x < display.width() + 4; x += 10)
+    for (int16_t y = 0; y < display.height() + 4; y += 10)
+      display.drawCircle(x, y, 5, WHITE);
+}
+
+void sceneTriangles() {
+  display.fillScreen(BLACK);
+  int16_t w = display.width() / 2, x = display.height(), y = 0;
+  int16_t z = display.width();
+  uint16_t color = RED;
+  for (uint8_t t = 0; t <= 15; t++) {
+    display.drawTriangle(w, y, y, x, z, x, color);
+    x -= 4;
+    y += 4;
+    z -= 4;
+    color += 100;
+  }
+}
+
+void sceneRoundRects() {
+  display.fillScreen(BLACK);
+  uint16_t color = 100;
+  for (uint8_t t = 0; t <= 4; t++) {
+    int16_t x = 0, y = 0, w = display.width(), h = display.height();
+    for (uint8_t i = 0; i <= 8; i++) {
+      display.drawRoundRect(x, y, w, h, 5, color);
+      x += 2;
+      y += 3;
+      w -= 4;
+      h -= 6;
+      color += 1100;
+    }
+    color += 100;
+  }
+}
+
+void sceneText() {
+  display.fillScreen(BLACK);
+  display.setCursor(0, 5);
+  display.setTextColor(RED);
+  display.setTextSize(1);
+  display.println("Hello World!");
+  display.setTextColor(YELLOW, GREEN);
+  display.setTextSize(2);
+  display.print("Hello Wo");
+  display.setTextColor(BLUE);
+  display.setTextSize(3);
+  display.print(1234.567);
+  display.setTextSize(1);
+}
+
+void sceneButtons() {
+  display.fillScreen(BLACK);
+  display.fillRoundRect(25, 10, 78, 60, 8, WHITE);
+  display.fillTriangle(42, 20, 42, 60, 90, 40, RED);
+  display.fillRoundRect(25, 90, 78, 60, 8, WHITE);
+  display.fillRoundRect(39, 98, 20, 45, 5, GREEN);
+  display.fillRoundRect(69, 98, 20, 45, 5, GREEN);
+  display.fillTriangle(42, 20, 42, 60, 90, 40, BLUE);
+}
+
+void sceneBitmaps() {
+  static const uint8_t smiley[] PROGMEM = {0x3C, 0x42, 0xA5, 0x81,
+                                           0xA5, 0x99, 0x42, 0x3C};
+  static uint16_t rgb[8 * 8];
+  for (uint8_t i = 0; i < 64; i++)
+    rgb[i] = i * 0x0421;
+  display.fillScreen(BLACK);
+  for (int16_t x = 0; x < display.width(); x += 16) {
+    display.drawBitmap(x, 0, smiley, 8, 8, YELLOW);
+    display.drawBitmap(x + 8, 8, smiley, 8, 8, RED, BLUE);
+    display.drawRGBBitmap(x, 24, rgb, 8, 8);
+  }
+}
+
+struct {
+  const char *name;
+  void (*draw)(void);
+} const scenes[] = {
+  {"pattern", scenePattern},       {"lines", sceneLines},
+  {"fastlines", sceneFastLines},   {"rects", sceneRects},
+  {"fillrects", sceneFillRects},   {"circles", sceneCircles},
+  {"triangles", sceneTriangles},   {"roundrects", sceneRoundRects},
+  {"text", sceneText},             {"buttons", sceneButtons},
+  {"bitmaps", sceneBitmaps},
+};
+const uint8_t numScenes = sizeof(scenes) / sizeof(scenes[0]);
+
+Counts counts[numScenes][2];
+
+// Prints one column of the table, returning true if it regressed.
+bool compare(uint32_t before, uint32_t now) {
+  Serial.print(',');
+  Serial.print(before);
+  Serial.print(',');
+  Serial.print(now);
+  Serial.print(',');
+  if (!before) {
+    Serial.print(now ? "new" : "0");
+    return now != 0;
+  }
+  int32_t delta = (int32_t)(now - before);
+  if (delta > 0)
+    Serial.print('+');
+  Serial.print((float)delta * 100 / before, 1);
+  Serial.print('%');
+  return (uint64_t)now * 100 > (uint64_t)before * (100 + THRESHOLD_PERCENT);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+
+  display.setBusTap(&model, true);
+  display.begin();
+
+  Serial.println("scene,rot,cmd_base,cmd,cmd_diff,data_base,data,data_diff,"
+                 "delay_base,delay,delay_diff");
+  bool failed = false;
+  for (uint8_t s = 0; s < numScenes; s++) {
+    for (uint8_t r = 0; r < 2; r++) {
+      display.setRotation(r);
+      model.reset();
+      scenes[s].draw();
+      Counts &c = counts[s][r];
+      c.cmd = model.commandBytes();
+      c.data = model.dataBytes();
+      c.delay = model.engineMicros();
+
+      const Counts &b = baseline[s][r];
+      Serial.print(scenes[s].name);
+      Serial.print(',');
+      Serial.print(r);
+      bool worse = compare(b.cmd, c.cmd);
+      worse |= compare(b.data, c.data);
+      worse |= compare(b.delay, c.delay);
+      Serial.println(worse ? ",REGRESSED" : "");
+      failed |= worse;
+    }
+  }
+  display.setRotation(0);
+  Serial.println(failed ? "FAIL" : "PASS");
+
+  Serial.println();
+  Serial.println("// Baseline from this run:");
+  Serial.println("const Counts baseline[][2] = {");
+  for (uint8_t s = 0; s < numScenes; s++) {
+    Serial.print("  ");
+    for (uint8_t r = 0; r < 2; r++) {
+      Serial.print(r ? ", {" : "{{");
+      Serial.print(counts[s][r].cmd);
+      Serial.print(", ");
+      Serial.print(counts[s][r].data);
+      Serial.print(", ");
+      Serial.print(counts[s][r].delay);
+      Serial.print('}');
+    }
+    Serial.print("}, // ");
+    Serial.println(scenes[s].name);
+  }
+  Serial.println("};");
+}
+
+void loop() {}
+
+#else
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+  Serial.println("Define SSD1331_BUS_TAP in Adafruit_SSD1331.h to run this");
+}
+
+void loop() {}
+#endif // SSD1331_BUS_TAP
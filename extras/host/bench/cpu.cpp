@@ -0,0 +1,125 @@
+/*
+ * CPU time of the driver's drawing paths, the same cases as the
+ * cpuBenchmark example, with Google Benchmark. It links against the plain
+ * library build, without the bus tap, and the host Adafruit_SPITFT only
+ * counts the bytes it is given, so the numbers are the driver's own
+ * clipping, coordinate and color work plus a function call per byte.
+ *
+ * To compare two versions, save each run with
+ *   make bench BENCH_ARGS=--benchmark_out=before.json
+ * and compare the files with tools/compare.py from Google Benchmark.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "Adafruit_SSD1331.h"
+
+static Adafruit_SSD1331 display(10, 8, 9);
+static uint16_t pixels[64];
+
+// Runs one drawing call per iteration, with the iteration count so each
+// call can vary a little, as in cpuBenchmark
+#define DRAW_BENCH(name, call)                                                 \
+  static void name(benchmark::State &state) {                                 \
+    uint32_t i = 0;                                                            \
+    for (auto _ : state) {                                                     \
+      call;                                                                    \
+      i++;                                                                     \
+    }                                                                          \
+    display.setRotation(0);                                                    \
+  }
+
+DRAW_BENCH(BM_drawPixel, display.drawPixel(i % 96, (i / 96) % 64, i))
+
+DRAW_BENCH(BM_writePixel_run32, {
+  display.startWrite();
+  for (int16_t x = 0; x < 32; x++)
+    display.writePixel(x, i % 64, i);
+  display.endWrite();
+})
+
+DRAW_BENCH(BM_fillRect, display.fillRect(i % 16, 8, 32, 24, i | 1))
+DRAW_BENCH(BM_fillRect_clipped,
+           display.fillRect(-16 + (int16_t)(i % 8), -8, 48, 24, i | 1))
+DRAW_BENCH(BM_fillRect_clear, display.fillRect(0, 0, 96, 64, 0))
+DRAW_BENCH(BM_drawLine, display.drawLine(0, 0, 95, i % 64, i))
+DRAW_BENCH(BM_drawLine_clipped, display.drawLine(-20, -10, 95, i % 64, i))
+DRAW_BENCH(BM_drawFastHLine, display.drawFastHLine(0, i % 64, 96, i))
+DRAW_BENCH(BM_drawRect, display.drawRect(i % 16, 8, 32, 24, i))
+DRAW_BENCH(BM_drawRect_clipped, display.drawRect(-8, -8, 32, 24, i))
+
+DRAW_BENCH(BM_setAddrWindow, {
+  display.startWrite();
+  display.setAddrWindow(i % 32, 8, 32, 24);
+  display.endWrite();
+})
+
+DRAW_BENCH(BM_writePixels_64, {
+  display.startWrite();
+  display.setAddrWindow(0, 0, 64, 1);
+  display.writePixels(pixels, 64);
+  display.endWrite();
+})
+
+DRAW_BENCH(BM_writeColor_64, {
+  display.startWrite();
+  display.setAddrWindow(0, 0, 64, 1);
+  display.writeColor(i, 64);
+  display.endWrite();
+})
+
+DRAW_BENCH(BM_writeColor_64_dither332, {
+  display.setColorDepth(SSD1331_COLORDEPTH_256, true);
+  display.startWrite();
+  display.setAddrWindow(0, 0, 64, 1);
+  display.writeColor(i, 64);
+  display.endWrite();
+  display.setColorDepth(SSD1331_COLORDEPTH_65K);
+})
+
+DRAW_BENCH(BM_color332,
+           benchmark::DoNotOptimize(Adafruit_SSD1331::color332(i)))
+DRAW_BENCH(BM_drawRGBBitmap_8x8, display.drawRGBBitmap(i % 32, 8, pixels, 8, 8))
+DRAW_BENCH(BM_drawChar, display.drawChar(i % 64, 8, 'A' + i % 26, 0xFFFF,
+                                         0x001F, 1))
+DRAW_BENCH(BM_setRotation, display.setRotation(i & 3))
+
+// Named as in cpuBenchmark, so runs on the host and on a board line up
+static const struct {
+  const char *name;
+  void (*bench)(benchmark::State &);
+} benches[] = {
+    {"BM_drawPixel", BM_drawPixel},
+    {"BM_writePixel/run32", BM_writePixel_run32},
+    {"BM_fillRect", BM_fillRect},
+    {"BM_fillRect/clipped", BM_fillRect_clipped},
+    {"BM_fillRect/clear", BM_fillRect_clear},
+    {"BM_drawLine", BM_drawLine},
+    {"BM_drawLine/clipped", BM_drawLine_clipped},
+    {"BM_drawFastHLine", BM_drawFastHLine},
+    {"BM_drawRect", BM_drawRect},
+    {"BM_drawRect/clipped", BM_drawRect_clipped},
+    {"BM_setAddrWindow", BM_setAddrWindow},
+    {"BM_writePixels/64", BM_writePixels_64},
+    {"BM_writeColor/64", BM_writeColor_64},
+    {"BM_writeColor/64/dither332", BM_writeColor_64_dither332},
+    {"BM_color332", BM_color332},
+    {"BM_drawRGBBitmap/8x8", BM_drawRGBBitmap_8x8},
+    {"BM_drawChar", BM_drawChar},
+    {"BM_setRotation", BM_setRotation},
+};
+
+int main(int argc, char **argv) {
+  display.begin();
+  for (uint8_t i = 0; i < 64; i++)
+    pixels[i] = i * 0x0421;
+  for (const auto &b : benches)
+    benchmark::RegisterBenchmark(b.name, b.bench);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,394 @@
+/*
+ * Host stand-in for Adafruit_SPITFT, see Adafruit_SPITFT.h. The clipping
+ * follows the Arduino library line for line.
+ */
+
+#include "Adafruit_SPITFT.h"
+#include <chrono>
+#include <thread>
+
+HostBus hostBus;
+SPIClass SPI;
+
+void HostBus::reset(void) {
+  transactions = commandBytes = dataBytes = dmaTransfers = errors = 0;
+  open = false;
+}
+
+Adafruit_SPITFT::Adafruit_SPITFT(uint16_t w, uint16_t h, int8_t cs, int8_t dc,
+                                 int8_t mosi, int8_t sck, int8_t rst,
+                                 int8_t miso)
+    : Adafruit_GFX(w, h), dcData(true), dmaColors(NULL) {}
+
+Adafruit_SPITFT::Adafruit_SPITFT(uint16_t w, uint16_t h, int8_t cs, int8_t dc,
+                                 int8_t rst)
+    : Adafruit_GFX(w, h), dcData(true), dmaColors(NULL) {}
+
+Adafruit_SPITFT::Adafruit_SPITFT(uint16_t w, uint16_t h, SPIClass *spiClass,
+                                 int8_t cs, int8_t dc, int8_t rst)
+    : Adafruit_GFX(w, h), dcData(true), dmaColors(NULL) {}
+
+void Adafruit_SPITFT::initSPI(uint32_t freq, uint8_t spiMode) {
+  (void)freq;
+  (void)spiMode;
+  dcData = true;
+}
+
+void Adafruit_SPITFT::startWrite(void) {
+  if (hostBus.open)
+    hostBus.errors++; // Would deadlock on cores that lock the bus
+  hostBus.open = true;
+  hostBus.transactions++;
+}
+
+void Adafruit_SPITFT::endWrite(void) {
+  if (!hostBus.open || dmaColors)
+    hostBus.errors++; // Chip select would rise mid-transfer
+  hostBus.open = false;
+}
+
+void Adafruit_SPITFT::sendCommand(uint8_t commandByte, uint8_t *dataBytes,
+                                  uint8_t numDataBytes) {
+  sendCommand(commandByte, (const uint8_t *)dataBytes, numDataBytes);
+}
+
+void Adafruit_SPITFT::sendCommand(uint8_t commandByte, const uint8_t *dataBytes,
+                                  uint8_t numDataBytes) {
+  Adafruit_SPITFT::startWrite();
+  SPI_DC_LOW();
+  spiWrite(commandByte);
+  SPI_DC_HIGH();
+  for (int i = 0; i < numDataBytes; i++)
+    spiWrite(*dataBytes++);
+  Adafruit_SPITFT::endWrite();
+}
+
+// Puts a byte on the bus
+void Adafruit_SPITFT::send(uint8_t b) {
+  if (!hostBus.open)
+    hostBus.errors++;
+  if (dcData)
+    hostBus.dataBytes++;
+  else
+    hostBus.commandBytes++;
+  hostAdvance(1); // 8 bits at 8MHz
+  if (hostBus.sink)
+    hostBus.sink(b, dcData, hostBus.sinkArg);
+}
+
+void Adafruit_SPITFT::spiWrite(uint8_t b) {
+  if (dmaColors) {
+    hostBus.errors++; // Would be mixed into the transfer; finish it first
+    dmaWait();
+  }
+  send(b);
+}
+
+void Adafruit_SPITFT::writeCommand(uint8_t cmd) {
+  SPI_DC_LOW();
+  spiWrite(cmd);
+  SPI_DC_HIGH();
+}
+
+void Adafruit_SPITFT::SPI_WRITE16(uint16_t w) {
+  spiWrite(w >> 8);
+  spiWrite(w);
+}
+
+void Adafruit_SPITFT::SPI_WRITE32(uint32_t l) {
+  SPI_WRITE16(l >> 16);
+  SPI_WRITE16(l);
+}
+
+void Adafruit_SPITFT::writePixel(int16_t x, int16_t y, uint16_t color) {
+  // Clip first...
+  if ((x >= 0) && (x < _width) && (y >= 0) && (y < _height)) {
+    // THEN set up transaction (if needed) and draw...
+    setAddrWindow(x, y, 1, 1);
+    SPI_WRITE16(color);
+  }
+}
+
+void Adafruit_SPITFT::writePixels(uint16_t *colors, uint32_t len, bool block,
+                                  bool bigEndian) {
+  if (!len)
+    return;
+  dmaWait(); // A transfer can't start until the last one is done
+  dmaColors = colors;
+  dmaLen = len;
+  dmaBigEndian = bigEndian;
+  if (block)
+    dmaWait();
+  else
+    hostBus.dmaTransfers++;
+}
+
+// Finishes the transfer in progress. Only now are its pixels read, so a
+// buffer changed while the transfer runs sends the changed pixels.
+void Adafruit_SPITFT::dmaWait(void) {
+  if (!dmaColors)
+    return;
+  if (hostBus.dmaMicros)
+    std::this_thread::sleep_for(std::chrono::microseconds(hostBus.dmaMicros));
+  uint16_t *colors = dmaColors;
+  dmaColors = NULL;
+  for (uint32_t i = 0; i < dmaLen; i++) {
+    uint16_t color = colors[i];
+    if (dmaBigEndian)
+      color = (color >> 8) | (color << 8);
+    send(color >> 8);
+    send(color);
+  }
+}
+
+void Adafruit_SPITFT::writeColor(uint16_t color, uint32_t len) {
+  while (len--)
+    SPI_WRITE16(color);
+}
+
+void Adafruit_SPITFT::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                                    uint16_t color) {
+  if (w && h) {   // Nonzero width and height?
+    if (w < 0) {  // If negative width...
+      x += w + 1; //   Move X to left edge
+      w = -w;     //   Use positive width
+    }
+    if (x < _width) { // Not off right
+      if (h < 0) {    // If negative height...
+        y += h + 1;   //   Move Y to top edge
+        h = -h;       //   Use positive height
+      }
+      if (y < _height) { // Not off bottom
+        int16_t x2 = x + w - 1;
+        if (x2 >= 0) { // Not off left
+          int16_t y2 = y + h - 1;
+          if (y2 >= 0) { // Not off top
+            // Rectangle partly or fully overlaps screen
+            if (x < 0) {
+              x = 0;
+              w = x2 + 1;
+            } // Clip left
+            if (y < 0) {
+              y = 0;
+              h = y2 + 1;
+            } // Clip top
+            if (x2 >= _width) {
+              w = _width - x;
+            } // Clip right
+            if (y2 >= _height) {
+              h = _height - y;
+            } // Clip bottom
+            writeFillRectPreclipped(x, y, w, h, color);
+          }
+        }
+      }
+    }
+  }
+}
+
+void Adafruit_SPITFT::writeFastHLine(int16_t x, int16_t y, int16_t w,
+                                     uint16_t color) {
+  if ((y >= 0) && (y < _height) && w) { // Y on screen, nonzero width
+    if (w < 0) {                        // If negative width...
+      x += w + 1;                       //   Move X to left edge
+      w = -w;                           //   Use positive width
+    }
+    if (x < _width) { // Not off right
+      int16_t x2 = x + w - 1;
+      if (x2 >= 0) { // Not off left
+        // Line partly or fully overlaps screen
+        if (x < 0) {
+          x = 0;
+          w = x2 + 1;
+        } // Clip left
+        if (x2 >= _width) {
+          w = _width - x;
+        } // Clip right
+        writeFillRectPreclipped(x, y, w, 1, color);
+      }
+    }
+  }
+}
+
+void Adafruit_SPITFT::writeFastVLine(int16_t x, int16_t y, int16_t h,
+                                     uint16_t color) {
+  if ((x >= 0) && (x < _width) && h) { // X on screen, nonzero height
+    if (h < 0) {                       // If negative height...
+      y += h + 1;                      //   Move Y to top edge
+      h = -h;                          //   Use positive height
+    }
+    if (y < _height) { // Not off bottom
+      int16_t y2 = y + h - 1;
+      if (y2 >= 0) { // Not off top
+        // Line partly or fully overlaps screen
+        if (y < 0) {
+          y = 0;
+          h = y2 + 1;
+        } // Clip top
+        if (y2 >= _height) {
+          h = _height - y;
+        } // Clip bottom
+        writeFillRectPreclipped(x, y, 1, h, color);
+      }
+    }
+  }
+}
+
+void Adafruit_SPITFT::writeFillRectPreclipped(int16_t x, int16_t y, int16_t w,
+                                              int16_t h, uint16_t color) {
+  setAddrWindow(x, y, w, h);
+  writeColor(color, (uint32_t)w * h);
+}
+
+void Adafruit_SPITFT::pushColor(uint16_t color) {
+  startWrite();
+  SPI_WRITE16(color);
+  endWrite();
+}
+
+void Adafruit_SPITFT::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  // Clip first...
+  if ((x >= 0) && (x < _width) && (y >= 0) && (y < _height)) {
+    // THEN set up transaction (if needed) and draw...
+    startWrite();
+    setAddrWindow(x, y, 1, 1);
+    SPI_WRITE16(color);
+    endWrite();
+  }
+}
+
+void Adafruit_SPITFT::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                               uint16_t color) {
+  if (w && h) {   // Nonzero width and height?
+    if (w < 0) {  // If negative width...
+      x += w + 1; //   Move X to left edge
+      w = -w;     //   Use positive width
+    }
+    if (x < _width) { // Not off right
+      if (h < 0) {    // If negative height...
+        y += h + 1;   //   Move Y to top edge
+        h = -h;       //   Use positive height
+      }
+      if (y < _height) { // Not off bottom
+        int16_t x2 = x + w - 1;
+        if (x2 >= 0) { // Not off left
+          int16_t y2 = y + h - 1;
+          if (y2 >= 0) { // Not off top
+            // Rectangle partly or fully overlaps screen
+            if (x < 0) {
+              x = 0;
+              w = x2 + 1;
+            } // Clip left
+            if (y < 0) {
+              y = 0;
+              h = y2 + 1;
+            } // Clip top
+            if (x2 >= _width) {
+              w = _width - x;
+            } // Clip right
+            if (y2 >= _height) {
+              h = _height - y;
+            } // Clip bottom
+            startWrite();
+            writeFillRectPreclipped(x, y, w, h, color);
+            endWrite();
+          }
+        }
+      }
+    }
+  }
+}
+
+void Adafruit_SPITFT::drawFastHLine(int16_t x, int16_t y, int16_t w,
+                                    uint16_t color) {
+  if ((y >= 0) && (y < _height) && w) { // Y on screen, nonzero width
+    if (w < 0) {                        // If negative width...
+      x += w + 1;                       //   Move X to left edge
+      w = -w;                           //   Use positive width
+    }
+    if (x < _width) { // Not off right
+      int16_t x2 = x + w - 1;
+      if (x2 >= 0) { // Not off left
+        // Line partly or fully overlaps screen
+        if (x < 0) {
+          x = 0;
+          w = x2 + 1;
+        } // Clip left
+        if (x2 >= _width) {
+          w = _width - x;
+        } // Clip right
+        startWrite();
+        writeFillRectPreclipped(x, y, w, 1, color);
+        endWrite();
+      }
+    }
+  }
+}
+
+void Adafruit_SPITFT::drawFastVLine(int16_t x, int16_t y, int16_t h,
+                                    uint16_t color) {
+  if ((x >= 0) && (x < _width) && h) { // X on screen, nonzero height
+    if (h < 0) {                       // If negative height...
+      y += h + 1;                      //   Move Y to top edge
+      h = -h;                          //   Use positive height
+    }
+    if (y < _height) { // Not off bottom
+      int16_t y2 = y + h - 1;
+      if (y2 >= 0) { // Not off top
+        // Line partly or fully overlaps screen
+        if (y < 0) {
+          y = 0;
+          h = y2 + 1;
+        } // Clip top
+        if (y2 >= _height) {
+          h = _height - y;
+        } // Clip bottom
+        startWrite();
+        writeFillRectPreclipped(x, y, 1, h, color);
+        endWrite();
+      }
+    }
+  }
+}
+
+void Adafruit_SPITFT::drawRGBBitmap(int16_t x, int16_t y, uint16_t *pcolors,
+                                    int16_t w, int16_t h) {
+  int16_t x2, y2;                 // Lower-right coord
+  if ((x >= _width) ||            // Off-edge right
+      (y >= _height) ||           // " top
+      ((x2 = (x + w - 1)) < 0) || // " left
+      ((y2 = (y + h - 1)) < 0))
+    return; // " bottom
+
+  int16_t bx1 = 0, by1 = 0, // Clipped top-left within bitmap
+      saveW = w;            // Save original bitmap width value
+  if (x < 0) {              // Clip left
+    w += x;
+    bx1 = -x;
+    x = 0;
+  }
+  if (y < 0) { // Clip top
+    h += y;
+    by1 = -y;
+    y = 0;
+  }
+  if (x2 >= _width)
+    w = _width - x; // Clip right
+  if (y2 >= _height)
+    h = _height - y; // Clip bottom
+
+  pcolors += by1 * saveW + bx1; // Offset bitmap ptr to clipped top-left
+  startWrite();
+  setAddrWindow(x, y, w, h); // Clipped area
+  while (h--) {              // For each (clipped) scanline...
+    writePixels(pcolors, w); // Push one (clipped) row
+    pcolors += saveW;        // Advance pointer by one full (unclipped) line
+  }
+  endWrite();
+}
+
+void Adafruit_SPITFT::invertDisplay(bool i) {
+  startWrite();
+  writeCommand(i ? invertOnCommand : invertOffCommand);
+  endWrite();
+}
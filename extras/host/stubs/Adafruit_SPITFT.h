@@ -0,0 +1,106 @@
+/*
+ * Host stand-in for Adafruit_SPITFT. Its drawing calls clip and send the
+ * same bytes as the Arduino library; the bytes themselves go to an optional
+ * sink (e.g. an SSD1331_Emulator) and are counted in hostBus, along with
+ * transactions and misuse of the bus. writePixels() with block false works
+ * like DMA on a SAMD51 or ESP32: the pixels are only read from memory when
+ * the transfer finishes, in dmaWait() or the next writePixels().
+ */
+
+#ifndef _HOST_ADAFRUIT_SPITFT_H_
+#define _HOST_ADAFRUIT_SPITFT_H_
+
+#include "Adafruit_GFX.h"
+#include "SPI.h"
+
+/// What the host SPI bus has seen, for tests to check
+struct HostBus {
+  uint32_t transactions; ///< Transactions begun
+  uint32_t commandBytes; ///< Bytes sent with D/C low
+  uint32_t dataBytes;    ///< Bytes sent with D/C high
+  uint32_t dmaTransfers; ///< writePixels() calls that didn't block
+  uint32_t errors;       ///< Bytes outside a transaction, nested or
+                         ///< unfinished transactions, writes during DMA
+  bool open;             ///< A transaction is in progress
+  /// Gets every byte sent, in order, if set
+  void (*sink)(uint8_t b, bool data, void *arg);
+  void *sinkArg;         ///< Passed to sink
+  uint32_t dmaMicros;    ///< Real time a DMA transfer takes, to widen races
+
+  void reset(void);
+};
+
+extern HostBus hostBus;
+
+/// Adafruit_SPITFT on a bus that goes nowhere
+class Adafruit_SPITFT : public Adafruit_GFX {
+public:
+  Adafruit_SPITFT(uint16_t w, uint16_t h, int8_t cs, int8_t dc, int8_t mosi,
+                  int8_t sck, int8_t rst = -1, int8_t miso = -1);
+  Adafruit_SPITFT(uint16_t w, uint16_t h, int8_t cs, int8_t dc,
+                  int8_t rst = -1);
+  Adafruit_SPITFT(uint16_t w, uint16_t h, SPIClass *spiClass, int8_t cs,
+                  int8_t dc, int8_t rst = -1);
+
+  virtual void begin(uint32_t freq) = 0;
+  virtual void setAddrWindow(uint16_t x, uint16_t y, uint16_t w,
+                             uint16_t h) = 0;
+
+  void initSPI(uint32_t freq = 0, uint8_t spiMode = SPI_MODE0);
+  void setSPISpeed(uint32_t freq) { (void)freq; }
+  void startWrite(void);
+  void endWrite(void);
+  void sendCommand(uint8_t commandByte, uint8_t *dataBytes,
+                   uint8_t numDataBytes);
+  void sendCommand(uint8_t commandByte, const uint8_t *dataBytes = NULL,
+                   uint8_t numDataBytes = 0);
+
+  void writePixel(int16_t x, int16_t y, uint16_t color);
+  void writePixels(uint16_t *colors, uint32_t len, bool block = true,
+                   bool bigEndian = false);
+  void writeColor(uint16_t color, uint32_t len);
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                     uint16_t color);
+  void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h,
+                               uint16_t color);
+  void dmaWait(void);
+  bool dmaBusy(void) const { return dmaColors != NULL; }
+
+  void pushColor(uint16_t color);
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  using Adafruit_GFX::drawRGBBitmap;
+  void drawRGBBitmap(int16_t x, int16_t y, uint16_t *pcolors, int16_t w,
+                     int16_t h);
+  void invertDisplay(bool i);
+  uint16_t color565(uint8_t r, uint8_t g, uint8_t b) {
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+  }
+
+  void spiWrite(uint8_t b);
+  void writeCommand(uint8_t cmd);
+  void SPI_WRITE16(uint16_t w);
+  void SPI_WRITE32(uint32_t l);
+  void SPI_DC_HIGH(void) { dcData = true; }
+  void SPI_DC_LOW(void) { dcData = false; }
+  void SPI_CS_HIGH(void) {}
+  void SPI_CS_LOW(void) {}
+
+protected:
+  void send(uint8_t b);
+
+  uint8_t invertOnCommand = 0;
+  uint8_t invertOffCommand = 0;
+
+private:
+  bool dcData;
+  uint16_t *dmaColors; // Pixels of the transfer in progress, or NULL
+  uint32_t dmaLen;
+  bool dmaBigEndian;
+};
+
+#endif // _HOST_ADAFRUIT_SPITFT_H_
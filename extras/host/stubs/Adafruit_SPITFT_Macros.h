@@ -0,0 +1 @@
+// Empty on the host; the SPITFT stub declares everything itself.
@@ -0,0 +1,189 @@
+/*
+ * Host implementation of the bits of the Arduino core in Arduino.h.
+ */
+
+#include "Arduino.h"
+#include <atomic>
+#include <unistd.h>
+
+static std::atomic<unsigned long> now(0), delayed(0);
+
+unsigned long micros(void) { return now; }
+unsigned long millis(void) { return now / 1000; }
+void hostAdvance(unsigned long us) { now += us; }
+unsigned long hostDelayed(void) { return delayed; }
+
+void delay(unsigned long ms) { delayMicroseconds(ms * 1000); }
+
+void delayMicroseconds(unsigned int us) {
+  now += us;
+  delayed += us;
+}
+
+// A fixed generator, so sketches draw the same thing on every host
+static uint32_t randomState = 1;
+
+void randomSeed(unsigned long seed) {
+  if (seed)
+    randomState = seed;
+}
+
+long random(long max) {
+  if (max <= 0)
+    return 0;
+  randomState = randomState * 1103515245UL + 12345;
+  return ((randomState >> 1) & 0x7FFFFFFF) % max;
+}
+
+long random(long min, long max) {
+  if (min >= max)
+    return min;
+  return random(max - min) + min;
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--)
+    n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(const char str[]) { return write(str); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(unsigned char b, int base) {
+  return print((unsigned long)b, base);
+}
+size_t Print::print(int n, int base) { return print((long)n, base); }
+size_t Print::print(unsigned int n, int base) {
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(long n, int base) {
+  if (base == 0)
+    return write((uint8_t)n);
+  if (base == 10 && n < 0)
+    return print('-') + printNumber(-(unsigned long)n, 10);
+  return printNumber(n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  if (base == 0)
+    return write((uint8_t)n);
+  return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) { return printFloat(n, digits); }
+
+size_t Print::println(void) { return write("\r\n"); }
+size_t Print::println(const char c[]) { return print(c) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(unsigned char b, int base) {
+  return print(b, base) + println();
+}
+size_t Print::println(int n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned int n, int base) {
+  return print(n, base) + println();
+}
+size_t Print::println(long n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned long n, int base) {
+  return print(n, base) + println();
+}
+size_t Print::println(double n, int digits) {
+  return print(n, digits) + println();
+}
+
+size_t Print::printf(const char *format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  return write(buf);
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+  char buf[8 * sizeof(long) + 1];
+  char *str = &buf[sizeof(buf) - 1];
+  *str = '\0';
+  if (base < 2)
+    base = 10;
+  do {
+    char c = n % base;
+    n /= base;
+    *--str = c < 10 ? c + '0' : c + 'A' - 10;
+  } while (n);
+  return write(str);
+}
+
+// The same steps as the Arduino core, so floats print the same
+size_t Print::printFloat(double number, uint8_t digits) {
+  size_t n = 0;
+  if (isnan(number))
+    return print("nan");
+  if (isinf(number))
+    return print("inf");
+  if (number > 4294967040.0 || number < -4294967040.0)
+    return print("ovf");
+  if (number < 0.0) {
+    n += print('-');
+    number = -number;
+  }
+
+  double rounding = 0.5;
+  for (uint8_t i = 0; i < digits; ++i)
+    rounding /= 10.0;
+  number += rounding;
+
+  unsigned long intPart = (unsigned long)number;
+  double remainder = number - (double)intPart;
+  n += print(intPart);
+  if (digits > 0)
+    n += print('.');
+  while (digits-- > 0) {
+    remainder *= 10.0;
+    unsigned int toPrint = (unsigned int)remainder;
+    n += print(toPrint);
+    remainder -= toPrint;
+  }
+  return n;
+}
+
+HostSerial Serial;
+
+// Reads all of stdin on first use, unless it's a terminal
+void HostSerial::fill(void) {
+  if (haveInput)
+    return;
+  haveInput = true;
+  if (isatty(0))
+    return;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), stdin)) > 0)
+    input.append(buf, n);
+}
+
+int HostSerial::available(void) {
+  fill();
+  return input.size() - inputAt;
+}
+
+int HostSerial::read(void) {
+  fill();
+  return inputAt < input.size() ? (uint8_t)input[inputAt++] : -1;
+}
+
+int HostSerial::peek(void) {
+  fill();
+  return inputAt < input.size() ? (uint8_t)input[inputAt] : -1;
+}
+
+size_t HostSerial::write(uint8_t c) { return write(&c, 1); }
+
+size_t HostSerial::write(const uint8_t *buffer, size_t size) {
+  if (capturing)
+    output.append((const char *)buffer, size);
+  else
+    fwrite(buffer, 1, size, stdout);
+  return size;
+}
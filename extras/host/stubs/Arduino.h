@@ -0,0 +1,166 @@
+/*
+ * Just enough of the Arduino core to build the library and its examples on
+ * a PC. Time is simulated: micros() only moves when the sketch delays or
+ * the SPI stub sends a byte (1us per byte, as at 8MHz), so runs repeat
+ * exactly. Serial writes to stdout and reads stdin, unless a test captures
+ * it.
+ */
+
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_pointer(addr) (*(void *const *)(addr))
+#define F(s) (s)
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+// Arduino's min() and max() are macros taking mixed types
+template <class T, class U>
+static inline auto min(T a, U b) ->
+    typename std::decay<decltype(a < b ? a : b)>::type {
+  return a < b ? a : b;
+}
+template <class T, class U>
+static inline auto max(T a, U b) ->
+    typename std::decay<decltype(a < b ? a : b)>::type {
+  return a > b ? a : b;
+}
+#define constrain(v, lo, hi) ((v) < (lo) ? (lo) : ((v) > (hi) ? (hi) : (v)))
+
+unsigned long micros(void);
+unsigned long millis(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+static inline void yield(void) {}
+
+// Host only: moves the simulated clock on, e.g. for bus time
+void hostAdvance(unsigned long us);
+// Host only: total time spent in delay() and delayMicroseconds()
+unsigned long hostDelayed(void);
+
+static inline void pinMode(uint8_t, uint8_t) {}
+static inline void digitalWrite(uint8_t, uint8_t) {}
+static inline int digitalRead(uint8_t) { return LOW; }
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+/// Arduino's Print, with the same number formatting
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) {
+    return str ? write((const uint8_t *)str, strlen(str)) : 0;
+  }
+  size_t write(const char *buffer, size_t size) {
+    return write((const uint8_t *)buffer, size);
+  }
+
+  size_t print(const char[]);
+  size_t print(const std::string &s) { return print(s.c_str()); }
+  size_t print(char);
+  size_t print(unsigned char, int = DEC);
+  size_t print(int, int = DEC);
+  size_t print(unsigned int, int = DEC);
+  size_t print(long, int = DEC);
+  size_t print(unsigned long, int = DEC);
+  size_t print(double, int = 2);
+
+  size_t println(const char[]);
+  size_t println(char);
+  size_t println(unsigned char, int = DEC);
+  size_t println(int, int = DEC);
+  size_t println(unsigned int, int = DEC);
+  size_t println(long, int = DEC);
+  size_t println(unsigned long, int = DEC);
+  size_t println(double, int = 2);
+  size_t println(void);
+
+  size_t printf(const char *format, ...)
+      __attribute__((format(printf, 2, 3)));
+
+private:
+  size_t printNumber(unsigned long n, uint8_t base);
+  size_t printFloat(double number, uint8_t digits);
+};
+
+/// Arduino's Stream, for reading
+class Stream : public Print {
+public:
+  virtual int available(void) = 0;
+  virtual int read(void) = 0;
+  virtual int peek(void) = 0;
+};
+
+/// Serial port on stdin and stdout
+class HostSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  void end(void) {}
+  void flush(void) { fflush(stdout); }
+  operator bool() const { return true; }
+
+  int available(void);
+  int read(void);
+  int peek(void);
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buffer, size_t size);
+  using Print::write;
+
+  // Host only: collect what's printed in a string instead of on stdout
+  void capture(bool on) {
+    capturing = on;
+    output.clear();
+  }
+  // Host only: what's been printed while capturing
+  const std::string &captured(void) const { return output; }
+  // Host only: read this instead of stdin
+  void setInput(const std::string &text) {
+    input = text;
+    inputAt = 0;
+    haveInput = true;
+  }
+
+private:
+  void fill(void);
+
+  std::string input, output;
+  size_t inputAt = 0;
+  bool haveInput = false, capturing = false;
+};
+
+extern HostSerial Serial;
+
+#if defined(ESP32)
+#include "freertos.h"
+#endif
+
+#endif // _HOST_ARDUINO_H_
@@ -0,0 +1,37 @@
+/*
+ * Host stand-in for the Arduino SPI library. Nothing is sent anywhere; the
+ * Adafruit_SPITFT stub does the bookkeeping.
+ */
+
+#ifndef _HOST_SPI_H_
+#define _HOST_SPI_H_
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+#define MSBFIRST 1
+#define LSBFIRST 0
+
+/// Transaction settings, ignored on the host
+class SPISettings {
+public:
+  SPISettings(void) {}
+  SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+/// An SPI bus that goes nowhere
+class SPIClass {
+public:
+  void begin(void) {}
+  void end(void) {}
+  void beginTransaction(SPISettings) {}
+  void endTransaction(void) {}
+  uint8_t transfer(uint8_t b) { return b; }
+};
+
+extern SPIClass SPI;
+
+#endif // _HOST_SPI_H_
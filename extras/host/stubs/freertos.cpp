@@ -0,0 +1,53 @@
+/*
+ * FreeRTOS task notifications on std::thread, see freertos.h.
+ */
+
+#include "Arduino.h"
+
+#if defined(ESP32)
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct HostTask {
+  std::mutex lock;
+  std::condition_variable wake;
+  uint32_t notified = 0;
+};
+
+// Tasks run forever, so they're never freed
+static thread_local HostTask *currentTask = NULL;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char *name,
+                                   uint32_t stackDepth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core) {
+  HostTask *task = new HostTask;
+  *handle = task;
+  std::thread([=] {
+    currentTask = task;
+    code(arg);
+  }).detach();
+  return pdPASS;
+}
+
+void xTaskNotifyGive(TaskHandle_t task) {
+  std::lock_guard<std::mutex> hold(task->lock);
+  task->notified++;
+  task->wake.notify_one();
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+  HostTask *task = currentTask;
+  std::unique_lock<std::mutex> hold(task->lock);
+  task->wake.wait(hold, [task] { return task->notified != 0; });
+  uint32_t n = task->notified;
+  task->notified = clearOnExit ? 0 : n - 1;
+  return n;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+#endif // ESP32
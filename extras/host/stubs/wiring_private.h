@@ -0,0 +1 @@
+// Empty on the host; the driver includes it for AVR port access.
@@ -0,0 +1,85 @@
+/*
+ * Flushes Adafruit_SSD1331_PaletteCanvas to an emulated display, checking
+ * the image and the driver's use of the bus.
+ */
+
+#include "host_test.h"
+
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_Canvas.h>
+#include <Adafruit_SSD1331_Emulator.h>
+
+// Feeds the bytes on the bus to an emulator
+static void toEmulator(uint8_t b, bool data, void *arg) {
+  ((SSD1331_Emulator *)arg)->busWrite(b, data);
+}
+
+class PaletteCanvas : public ::testing::Test {
+protected:
+  void SetUp(void) {
+    hostBus.reset();
+    hostBus.sink = toEmulator;
+    hostBus.sinkArg = &emulator;
+    display.begin();
+    const uint16_t colors[] = {0x0000, 0xF800, 0x07E0, 0x001F};
+    canvas.setPalette(colors, 4);
+    canvas.fillScreen(0);
+    canvas.flush(display);
+  }
+  void TearDown(void) { hostBus.sink = NULL; }
+
+  // The display shows the canvas through its palette
+  void expectShown(void) {
+    const uint16_t *ram = emulator.getBuffer();
+    for (int16_t y = 0; y < canvas.height(); y++) {
+      for (int16_t x = 0; x < canvas.width(); x++) {
+        uint16_t want = canvas.getPaletteColor(canvas.getPixel(x, y));
+        if (ram[y * Adafruit_SSD1331::TFTWIDTH + x] != want) {
+          ADD_FAILURE() << "pixel (" << x << ", " << y << ") differs";
+          return;
+        }
+      }
+    }
+  }
+
+  Adafruit_SSD1331 display{10, 8, 9};
+  SSD1331_Emulator emulator;
+  Adafruit_SSD1331_PaletteCanvas canvas{4};
+};
+
+// Each region is a run of its own, so the window moves while the last row
+// of the run before may still be going out by DMA
+TEST_F(PaletteCanvas, FlushSeveralRuns) {
+  hostBus.reset();
+  canvas.fillRect(2, 3, 10, 4, 1);
+  canvas.fillRect(60, 3, 12, 4, 2);
+  canvas.fillRect(30, 40, 20, 12, 3);
+  canvas.flush(display);
+  EXPECT_GT(hostBus.dmaTransfers, 0u);
+  EXPECT_EQ(hostBus.errors, 0u);
+  EXPECT_FALSE(canvas.isDirty());
+  expectShown();
+}
+
+// Slices end with nothing in flight, so the display can be drawn to in
+// between; the pixel drawn is in a tile the canvas leaves alone
+TEST_F(PaletteCanvas, ServiceInSlices) {
+  hostBus.reset();
+  canvas.fillRect(2, 3, 10, 4, 1);
+  canvas.fillRect(60, 3, 12, 4, 2);
+  canvas.fillRect(30, 40, 20, 12, 3);
+  uint16_t slices = 0;
+  while (canvas.service(display, 50)) {
+    slices++;
+    EXPECT_FALSE(display.dmaBusy());
+    display.drawPixel(90, 60, 0xFFFF);
+  }
+  EXPECT_GT(slices, 2u);
+  EXPECT_GT(hostBus.dmaTransfers, 0u);
+  EXPECT_EQ(hostBus.errors, 0u);
+  EXPECT_EQ(emulator.getBuffer()[60 * Adafruit_SSD1331::TFTWIDTH + 90],
+            0xFFFF);
+  // Back to what the canvas holds there, for expectShown()
+  emulator.getBuffer()[60 * Adafruit_SSD1331::TFTWIDTH + 90] = 0;
+  expectShown();
+}
@@ -0,0 +1,16 @@
+/*
+ * Runs the clipFuzz example, which draws random shapes, mostly partly off
+ * screen, on the display and on a canvas and compares the two after each.
+ */
+
+#include "host_test.h"
+
+#include "examples/clipFuzz/clipFuzz.ino"
+
+TEST(ClipFuzz, SketchPasses) {
+  Serial.capture(true);
+  setup();
+  std::string output = Serial.captured();
+  Serial.capture(false);
+  EXPECT_NE(output.find("\r\nPASS\r\n"), std::string::npos) << output;
+}
@@ -0,0 +1,73 @@
+/*
+ * Runs Adafruit_SSD1331_DoubleBuffer's flush task on a thread of its own,
+ * as on a dual-core ESP32, while the test draws frames on the main thread.
+ * DMA transfers are slowed down so that a frame handed over before its
+ * pixels have gone out shows up in the image.
+ */
+
+#include "host_test.h"
+
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_DoubleBuffer.h>
+#include <Adafruit_SSD1331_Emulator.h>
+#include <thread>
+#include <vector>
+
+// Feeds the bytes on the bus to an emulator
+static void toEmulator(uint8_t b, bool data, void *arg) {
+  ((SSD1331_Emulator *)arg)->busWrite(b, data);
+}
+
+// The flush task never ends, so what it uses must outlive the test
+static Adafruit_SSD1331 display(10, 8, 9);
+static SSD1331_Emulator emulator;
+static Adafruit_SSD1331_DoubleBuffer frames(display);
+
+// Draws frame n over the one before, changing a few tiles
+static void drawFrame(uint16_t n) {
+  if (!n)
+    frames.fillScreen(0x0010);
+  frames.fillRect(random(80), random(48), 16, 16, random(0x10000));
+  frames.drawLine(random(96), random(64), random(96), random(64), n * 0x0841);
+  frames.setCursor(random(60), random(56));
+  frames.setTextColor(0xFFFF, 0x0010);
+  frames.print(n);
+}
+
+// The emulator holds what's on screen once the frame is flushed
+static void expectShown(const std::vector<uint16_t> &frame, uint16_t n) {
+  while (frames.flushing())
+    std::this_thread::yield();
+  SCOPED_TRACE("frame " + std::to_string(n));
+  EXPECT_EQ(memcmp(emulator.getBuffer(), frame.data(),
+                   frame.size() * sizeof(uint16_t)),
+            0);
+}
+
+TEST(DoubleBuffer, FlushTaskShowsEveryFrame) {
+  hostBus.reset();
+  hostBus.sink = toEmulator;
+  hostBus.sinkArg = &emulator;
+  hostBus.dmaMicros = 20;
+  display.begin();
+  ASSERT_TRUE(frames.getBuffer() != NULL);
+  ASSERT_TRUE(frames.startFlushTask());
+
+  const size_t pixels = Adafruit_SSD1331::TFTWIDTH *
+                        Adafruit_SSD1331::TFTHEIGHT;
+  std::vector<uint16_t> shown;
+  for (uint16_t n = 0; n < 40; n++) {
+    drawFrame(n); // While the last frame is going out
+    // Every other frame, look at the last one before handing this one
+    // over; otherwise swap() has to wait for the flush by itself
+    if (!shown.empty() && n % 2)
+      expectShown(shown, n - 1);
+    shown.assign(frames.getBuffer(), frames.getBuffer() + pixels);
+    frames.swap();
+  }
+  expectShown(shown, 39);
+  EXPECT_GT(hostBus.dmaTransfers, 0u);
+  EXPECT_EQ(hostBus.errors, 0u);
+  hostBus.sink = NULL;
+  hostBus.dmaMicros = 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * Checks the driver's use of the bus.
+ */
+
+#include "host_test.h"
+
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_DisplayList.h>
+#include <Adafruit_SSD1331_Emulator.h>
+
+// Feeds the bytes on the bus to an emulator
+static void toEmulator(uint8_t b, bool data, void *arg) {
+  ((SSD1331_Emulator *)arg)->busWrite(b, data);
+}
+
+// Draws a bit of everything
+static void drawAll(Adafruit_SSD1331 &display) {
+  display.fillScreen(0x1234);
+  display.fillRect(3, 4, 20, 10, 0xF800);
+  display.drawRect(-5, 10, 30, 20, 0x07E0);
+  display.drawLine(0, 63, 95, 0, 0x001F);
+  display.drawFastHLine(0, 5, 96, 0xFFFF);
+  display.drawPixel(50, 50, 0xFFE0);
+  display.fillCircle(60, 30, 10, 0xF81F);
+  display.setCursor(2, 40);
+  display.print("Host");
+  display.setRotation(1);
+  display.fillTriangle(0, 0, 63, 20, 10, 95, 0x07FF);
+  display.setRotation(0);
+}
+
+class Driver : public ::testing::Test {
+protected:
+  void SetUp(void) {
+    hostBus.reset();
+    hostBus.sink = NULL;
+  }
+  Adafruit_SSD1331 display{10, 8, 9};
+};
+
+TEST_F(Driver, OfflineTapKeepsOffTheBus) {
+  SSD1331_Emulator emulator;
+  display.setBusTap(&emulator, true);
+  display.begin();
+  drawAll(display);
+  EXPECT_EQ(hostBus.transactions, 0u);
+  EXPECT_EQ(hostBus.commandBytes + hostBus.dataBytes, 0u);
+  EXPECT_EQ(hostBus.errors, 0u);
+  EXPECT_GT(emulator.commandBytes(), 0u);
+}
+
+TEST_F(Driver, TapSeesWhatTheBusSees) {
+  SSD1331_Emulator tapped, wired;
+  hostBus.sink = toEmulator;
+  hostBus.sinkArg = &wired;
+  display.setBusTap(&tapped);
+  display.begin();
+  drawAll(display);
+  EXPECT_EQ(hostBus.errors, 0u);
+  EXPECT_EQ(tapped.commandBytes(), hostBus.commandBytes);
+  EXPECT_EQ(tapped.dataBytes(), hostBus.dataBytes);
+  EXPECT_EQ(tapped.crc32(), wired.crc32());
+}
+
+TEST_F(Driver, TransactionsBalanceWithoutTap) {
+  SSD1331_Emulator wired;
+  hostBus.sink = toEmulator;
+  hostBus.sinkArg = &wired;
+  display.begin();
+  drawAll(display);
+  EXPECT_EQ(hostBus.errors, 0u);
+  EXPECT_FALSE(hostBus.open);
+  EXPECT_GT(hostBus.transactions, 0u);
+}
+
+TEST_F(Driver, BeginForgetsPixelRun) {
+  SSD1331_Emulator emulator;
+  display.setBusTap(&emulator, true);
+  display.begin();
+  display.drawPixel(10, 10, 0xFFFF);
+  uint32_t before = emulator.commandBytes();
+  display.drawPixel(11, 10, 0xFFFF);
+  EXPECT_EQ(emulator.commandBytes(), before) << "Run should continue";
+
+  display.begin();
+  before = emulator.commandBytes();
+  display.drawPixel(12, 10, 0xF800);
+  EXPECT_EQ(emulator.commandBytes() - before,
+            (uint32_t)SSD1331_BYTES_WINDOW);
+  EXPECT_EQ(emulator.getPixel(12, 10), 0xF800);
+}
+
+// A run opened while offline exists only in the tap, so going back online
+// must open a window on the panel
+TEST_F(Driver, SetBusTapForgetsPixelRun) {
+  SSD1331_Emulator wired, offline;
+  hostBus.sink = toEmulator;
+  hostBus.sinkArg = &wired;
+  display.begin();
+  display.setBusTap(&offline, true);
+  display.drawPixel(10, 10, 0xFFFF);
+
+  display.setBusTap(NULL);
+  uint32_t before = hostBus.commandBytes;
+  display.drawPixel(11, 10, 0xF800);
+  EXPECT_EQ(hostBus.commandBytes - before, (uint32_t)SSD1331_BYTES_WINDOW);
+  EXPECT_EQ(wired.getPixel(11, 10), 0xF800);
+  EXPECT_EQ(hostBus.errors, 0u);
+}
+
+TEST_F(Driver, PushColorPacksIn256ColorMode) {
+  SSD1331_Emulator emulator;
+  display.setBusTap(&emulator, true);
+  display.begin();
+  display.setColorDepth(SSD1331_COLORDEPTH_256);
+  display.startWrite();
+  display.setAddrWindow(10, 10, 2, 1);
+  display.endWrite();
+  uint32_t before = emulator.dataBytes();
+  display.pushColor(0xF800);
+  display.pushColor(0x001F);
+  EXPECT_EQ(emulator.dataBytes() - before, 2u);
+  EXPECT_EQ(emulator.getPixel(10, 10), 0xF800);
+  EXPECT_EQ(emulator.getPixel(11, 10), 0x001F);
+}
+
+TEST_F(Driver, DisplayListLeavesTextSettings) {
+  SSD1331_Emulator emulator;
+  display.setBusTap(&emulator, true);
+  display.begin();
+  display.setCursor(7, 9);
+
+  Adafruit_SSD1331_DisplayList list(display);
+  list.beginFrame();
+  list.drawText(20, 30, "List", 0xFFFF, 2);
+  list.endFrame();
+
+  EXPECT_EQ(display.getCursorX(), 7);
+  EXPECT_EQ(display.getCursorY(), 9);
+  EXPECT_NE(emulator.getPixel(21, 31), 0); // The text was drawn
+}
+
+// A GFXfont with a single glyph, a 4x4 block standing on the baseline
+static const uint8_t blockBitmap[] = {0xFF, 0xFF};
+static const GFXglyph blockGlyph = {0, 4, 4, 5, 0, -4};
+static const GFXfont blockFont = {(uint8_t *)blockBitmap,
+                                  (GFXglyph *)&blockGlyph, 'A', 'A', 6};
+
+TEST_F(Driver, DisplayListTextUsesItsFont) {
+  SSD1331_Emulator emulator;
+  display.setBusTap(&emulator, true);
+  display.begin();
+  display.fillScreen(0);
+
+  Adafruit_SSD1331_DisplayList list(display);
+  list.beginFrame();
+  list.setFont(&blockFont);
+  list.drawText(10, 20, "A", 0xFFFF);
+  list.endFrame();
+  EXPECT_EQ(emulator.getPixel(10, 16), 0xFFFF); // Above the baseline
+  EXPECT_EQ(emulator.getPixel(13, 19), 0xFFFF);
+  EXPECT_EQ(emulator.getPixel(10, 20), 0);
+
+  // The same text in the built-in font is a change, and the block, which
+  // is above where the built-in font draws, is erased
+  list.beginFrame();
+  list.setFont();
+  list.drawText(10, 20, "A", 0xFFFF);
+  list.endFrame();
+  EXPECT_EQ(emulator.getPixel(10, 16), 0);
+  EXPECT_EQ(emulator.getPixel(13, 19), 0);
+  EXPECT_NE(emulator.getPixel(12, 20), 0); // Top of the built-in A
+}
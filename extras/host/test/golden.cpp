@@ -0,0 +1,40 @@
+/*
+ * Runs the goldenImage example and checks its image against the golden PPM.
+ */
+
+#include "host_test.h"
+
+#include "examples/goldenImage/goldenImage.ino"
+
+// Runs setup() once, returning what it printed
+static const std::string &sketchOutput(void) {
+  static std::string output;
+  if (output.empty()) {
+    Serial.capture(true);
+    setup();
+    output = Serial.captured();
+    Serial.capture(false);
+  }
+  return output;
+}
+
+TEST(GoldenImage, SketchPasses) {
+  EXPECT_NE(sketchOutput().find("PASS"), std::string::npos) << sketchOutput();
+}
+
+TEST(GoldenImage, MatchesPPM) {
+  sketchOutput();
+  StringPrint ppm;
+  emulator.printPPM(ppm);
+  expectGolden("goldenImage.ppm", ppm.text);
+}
+
+TEST(GoldenImage, PrintsPPMOnRequest) {
+  sketchOutput();
+  Serial.setInput("p");
+  Serial.capture(true);
+  loop();
+  EXPECT_EQ(Serial.captured().compare(0, 3, "P6\n"), 0);
+  EXPECT_EQ(Serial.captured().size(), 13u + 96 * 64 * 3);
+  Serial.capture(false);
+}
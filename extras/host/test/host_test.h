@@ -0,0 +1,45 @@
+/*
+ * Helpers shared by the host tests.
+ */
+
+#ifndef _HOST_TEST_H_
+#define _HOST_TEST_H_
+
+#include <Arduino.h>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+/// A Print that collects everything in a string
+class StringPrint : public Print {
+public:
+  size_t write(uint8_t c) {
+    text += (char)c;
+    return 1;
+  }
+  using Print::write;
+  std::string text;
+};
+
+/// Checks data against the file name in GOLDEN_DIR. With UPDATE_GOLDENS set
+/// in the environment, rewrites the file instead. On a mismatch, the data is
+/// saved in the build directory for a look.
+inline void expectGolden(const char *name, const std::string &data) {
+  std::string path = std::string(GOLDEN_DIR "/") + name;
+  if (getenv("UPDATE_GOLDENS")) {
+    std::ofstream(path, std::ios::binary) << data;
+    return;
+  }
+  std::ifstream in(path, std::ios::binary);
+  ASSERT_TRUE(in.good()) << "No golden file " << path;
+  std::stringstream golden;
+  golden << in.rdbuf();
+  if (golden.str() != data) {
+    std::string actual = std::string(BUILD_DIR "/") + name;
+    std::ofstream(actual, std::ios::binary) << data;
+    ADD_FAILURE() << name << " differs from the golden file, see " << actual;
+  }
+}
+
+#endif // _HOST_TEST_H_
@@ -0,0 +1,50 @@
+/*
+ * Flushes an Adafruit_SSD1331_Compositor to an emulated display, checking
+ * the image and the driver's use of the bus.
+ */
+
+#include "host_test.h"
+
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_Emulator.h>
+#include <Adafruit_SSD1331_Layers.h>
+
+// Feeds the bytes on the bus to an emulator
+static void toEmulator(uint8_t b, bool data, void *arg) {
+  ((SSD1331_Emulator *)arg)->busWrite(b, data);
+}
+
+// Two regions far apart are two runs, so the window moves while the last
+// row of the first may still be going out by DMA
+TEST(Compositor, FlushSeparateRegions) {
+  Adafruit_SSD1331 display(10, 8, 9);
+  SSD1331_Emulator emulator;
+  hostBus.reset();
+  hostBus.sink = toEmulator;
+  hostBus.sinkArg = &emulator;
+  display.begin();
+
+  Adafruit_SSD1331_Layer layer;
+  Adafruit_SSD1331_Compositor compositor(0x0000);
+  ASSERT_TRUE(compositor.addLayer(&layer));
+  layer.fillScreen(0x1234);
+  compositor.markAllDirty();
+  compositor.flush(display);
+
+  hostBus.reset();
+  layer.fillRect(2, 3, 10, 4, 0xF800);
+  layer.fillRect(50, 40, 20, 12, 0x07E0);
+  compositor.flush(display);
+  EXPECT_GT(hostBus.dmaTransfers, 0u);
+  EXPECT_EQ(hostBus.errors, 0u);
+  hostBus.sink = NULL;
+
+  const uint16_t *ram = emulator.getBuffer(), *want = layer.getBuffer();
+  for (uint16_t i = 0; i < Adafruit_SSD1331::TFTWIDTH *
+                               Adafruit_SSD1331::TFTHEIGHT; i++) {
+    if (ram[i] != want[i]) {
+      ADD_FAILURE() << "pixel " << i << " differs";
+      break;
+    }
+  }
+}
@@ -0,0 +1,40 @@
+/*
+ * Runs the regressionGate example, which fails if drawing any of its scenes
+ * sends more bytes or waits longer than its baseline allows.
+ */
+
+#include "host_test.h"
+
+#include "examples/regressionGate/regressionGate.ino"
+
+// Runs setup() once, returning what it printed
+static const std::string &sketchOutput(void) {
+  static std::string output;
+  if (output.empty()) {
+    Serial.capture(true);
+    setup();
+    output = Serial.captured();
+    Serial.capture(false);
+  }
+  return output;
+}
+
+TEST(RegressionGate, SketchPasses) {
+  EXPECT_NE(sketchOutput().find("\r\nPASS\r\n"), std::string::npos)
+      << sketchOutput();
+}
+
+// Counts are exact on the host, so any change, better or worse, should come
+// with a new baseline: paste the block the sketch prints into it.
+TEST(RegressionGate, BaselineIsCurrent) {
+  sketchOutput();
+  for (uint8_t s = 0; s < numScenes; s++) {
+    for (uint8_t r = 0; r < 2; r++) {
+      SCOPED_TRACE(std::string(scenes[s].name) + ", rotation " +
+                   std::to_string(r));
+      EXPECT_EQ(counts[s][r].cmd, baseline[s][r].cmd);
+      EXPECT_EQ(counts[s][r].data, baseline[s][r].data);
+      EXPECT_EQ(counts[s][r].delay, baseline[s][r].delay);
+    }
+  }
+}
@@ -0,0 +1,153 @@
+/*
+ * Checks Adafruit_SSD1331_SpriteLayer against a software composite: the
+ * background with every live sprite drawn over it in slot order. Sprites
+ * are stamped, moved and removed while overlapping each other and the
+ * edges of the screen, and the emulated display must match the composite
+ * after each step.
+ */
+
+#include "host_test.h"
+
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_Emulator.h>
+#include <Adafruit_SSD1331_Sprites.h>
+
+static const int16_t W = Adafruit_SSD1331::TFTWIDTH;
+static const int16_t H = Adafruit_SSD1331::TFTHEIGHT;
+
+// A background that differs at every pixel, so restoring the wrong area
+// shows up
+static uint16_t background(int16_t x, int16_t y) {
+  return (x * 0x0841) ^ (y << 11) ^ (y >> 2);
+}
+
+static void drawBackground(Adafruit_SSD1331 &display, int16_t x, int16_t y,
+                           int16_t w, int16_t h) {
+  for (int16_t j = y; j < y + h; j++)
+    for (int16_t i = x; i < x + w; i++)
+      display.drawPixel(i, j, background(i, j));
+}
+
+class Sprites : public ::testing::Test {
+protected:
+  struct Placed {
+    const uint16_t *bitmap;
+    int16_t x, y, w, h;
+  };
+
+  void SetUp(void) {
+    for (uint16_t i = 0; i < 12 * 12; i++) {
+      // Every pixel of each image different, and the images different
+      // from each other
+      images[0][i] = i * 0x0123 + 1;
+      images[1][i] = ~(i * 0x0321);
+      images[2][i] = (i << 8) ^ (i * 7);
+    }
+    display.setBusTap(&emulator, true);
+    display.begin();
+    drawBackground(display, 0, 0, W, H);
+    layer.setBackground(drawBackground);
+  }
+
+  int8_t add(uint8_t image, int16_t w, int16_t h, int16_t x, int16_t y) {
+    int8_t id = layer.add(images[image], w, h, x, y, false);
+    if (id >= 0)
+      placed[id] = {images[image], x, y, w, h};
+    return id;
+  }
+  void moveTo(int8_t id, int16_t x, int16_t y) {
+    layer.moveTo(id, x, y);
+    placed[id].x = x;
+    placed[id].y = y;
+  }
+  void remove(int8_t id) {
+    layer.remove(id);
+    placed[id].bitmap = NULL;
+  }
+
+  // Compares the display with the background and the sprites drawn over
+  // it in slot order
+  void expectComposite(const std::string &step) {
+    GFXcanvas16 canvas(W, H);
+    for (int16_t y = 0; y < H; y++)
+      for (int16_t x = 0; x < W; x++)
+        canvas.drawPixel(x, y, background(x, y));
+    for (const Placed &p : placed) {
+      if (p.bitmap)
+        canvas.drawRGBBitmap(p.x, p.y, p.bitmap, p.w, p.h);
+    }
+    const uint16_t *ram = emulator.getBuffer();
+    for (int16_t y = 0; y < H; y++) {
+      for (int16_t x = 0; x < W; x++) {
+        if (ram[y * W + x] != canvas.getPixel(x, y)) {
+          ADD_FAILURE() << step << ": pixel (" << x << ", " << y
+                        << ") differs";
+          return;
+        }
+      }
+    }
+  }
+
+  Adafruit_SSD1331 display{10, 8, 9};
+  SSD1331_Emulator emulator;
+  Adafruit_SSD1331_SpriteLayer layer{display, 6};
+  uint16_t images[3][12 * 12];
+  Placed placed[6] = {};
+};
+
+// The first sprite with an image is covered by another, so the next one
+// with the same image must not be copied from it
+TEST_F(Sprites, StampSkipsCoveredSource) {
+  add(0, 12, 12, 10, 10);
+  add(1, 12, 12, 16, 14);
+  expectComposite("cover");
+  add(0, 12, 12, 50, 30);
+  expectComposite("stamp");
+}
+
+TEST_F(Sprites, StampFromUncoveredSource) {
+  add(0, 12, 12, 10, 10);
+  add(1, 12, 12, 16, 14);
+  add(0, 12, 12, 60, 10);
+  add(0, 12, 12, 40, 40); // May be copied from the one at (60, 10)
+  expectComposite("stamp");
+}
+
+// A sprite added under one in a later slot must stay underneath
+TEST_F(Sprites, AddKeepsSlotOrder) {
+  int8_t a = add(0, 12, 12, 10, 10);
+  add(1, 12, 12, 16, 14);
+  remove(a);
+  add(2, 12, 12, 20, 20); // Takes slot 0, under slot 1
+  expectComposite("add under");
+}
+
+TEST_F(Sprites, RandomMoves) {
+  randomSeed(30);
+  for (uint16_t n = 0; n < 2000; n++) {
+    int8_t id = random(6);
+    int16_t x = random(-8, W), y = random(-8, H);
+    std::string step = "step " + std::to_string(n);
+    if (!placed[id].bitmap) {
+      uint8_t image = random(3);
+      int8_t got = add(image, 12, 12, x, y);
+      step += ": add image " + std::to_string(image) + " as " +
+              std::to_string(got);
+    } else if (random(8)) {
+      // Mostly small steps, which the copy path can take
+      if (random(2)) {
+        x = placed[id].x + random(-4, 5);
+        y = placed[id].y + random(-4, 5);
+      }
+      moveTo(id, x, y);
+      step += ": move " + std::to_string(id);
+    } else {
+      remove(id);
+      step += ": remove " + std::to_string(id);
+    }
+    step += " at (" + std::to_string(x) + ", " + std::to_string(y) + ")";
+    expectComposite(step);
+    if (HasFailure())
+      return;
+  }
+}
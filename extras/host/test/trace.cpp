@@ -0,0 +1,109 @@
+/*
+ * Checks that a bus trace survives being dumped as text and read back, by
+ * SSD1331_TraceRecorder and by the trace_replay tool.
+ */
+
+#include "host_test.h"
+
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_Emulator.h>
+#include <Adafruit_SSD1331_Trace.h>
+#include <stdio.h>
+
+// Feeds the bytes on the bus to an emulator
+static void toEmulator(uint8_t b, bool data, void *arg) {
+  ((SSD1331_Emulator *)arg)->busWrite(b, data);
+}
+
+class Trace : public ::testing::Test {
+protected:
+  // Draws with the trace attached from before begin(), and the bytes that
+  // reach the bus going to wired
+  void SetUp(void) {
+    hostBus.reset();
+    hostBus.sink = toEmulator;
+    hostBus.sinkArg = &wired;
+    display.setBusTap(&trace);
+    display.begin();
+    display.fillScreen(0x1234);
+    display.fillRect(3, 4, 20, 10, 0xF800);
+    display.drawLine(0, 63, 95, 0, 0x001F);
+    display.setRotation(1);
+    display.drawPixel(5, 80, 0xFFE0);
+    display.setCursor(2, 40);
+    display.print("Trace");
+    hostAdvance(500); // An idle bus, for printGaps()
+    display.fillCircle(30, 30, 10, 0xF81F);
+    display.setBusTap(NULL);
+    hostBus.sink = NULL;
+    trace.printTo(dump);
+  }
+
+  Adafruit_SSD1331 display{10, 8, 9};
+  SSD1331_TraceRecorder trace{256, 8192};
+  SSD1331_Emulator wired;
+  StringPrint dump;
+};
+
+TEST_F(Trace, HoldsEverything) {
+  EXPECT_EQ(trace.dropped(), 0u);
+  SSD1331_Emulator replayed;
+  trace.replay(replayed);
+  EXPECT_EQ(replayed.crc32(), wired.crc32());
+}
+
+TEST_F(Trace, ParsesItsOwnDump) {
+  SSD1331_TraceRecorder parsed(256, 8192);
+  parsed.parse(dump.text.c_str());
+  StringPrint again;
+  parsed.printTo(again);
+  EXPECT_EQ(again.text, dump.text);
+}
+
+// Keeps only the end of the drawing, so replaying relies on the remap
+// setting the trace restores
+TEST_F(Trace, ParsesIntoSmallerRecorder) {
+  SSD1331_TraceRecorder small(8, 256);
+  small.parse(dump.text.c_str());
+  EXPECT_GT(small.dropped(), 0u);
+  SSD1331_Emulator fromDump, fromTrace;
+  small.replay(fromDump);
+
+  SSD1331_TraceRecorder tail(8, 256);
+  trace.replay(tail);
+  tail.replay(fromTrace);
+  EXPECT_EQ(fromDump.crc32(), fromTrace.crc32());
+}
+
+TEST_F(Trace, ReplayTool) {
+  std::string path = BUILD_DIR "/trace.txt", image = BUILD_DIR "/trace.ppm";
+  std::ofstream(path) << dump.text;
+  std::string cmd =
+      BUILD_DIR "/trace_replay -g 400 -o " + image + " " + path + " 2>&1";
+  FILE *tool = popen(cmd.c_str(), "r");
+  ASSERT_TRUE(tool != NULL);
+  std::string output;
+  for (int c; (c = fgetc(tool)) != EOF;)
+    output += (char)c;
+  EXPECT_EQ(pclose(tool), 0) << output;
+
+  char crc[32];
+  snprintf(crc, sizeof(crc), "Image CRC: 0x%lX\r\n",
+           (unsigned long)wired.crc32());
+  EXPECT_NE(output.find(crc), std::string::npos) << output;
+  EXPECT_NE(output.find("gap 500 us"), std::string::npos) << output;
+  EXPECT_NE(output.find("Command bytes: " +
+                        std::to_string(hostBus.commandBytes)),
+            std::string::npos)
+      << output;
+  EXPECT_NE(output.find("Data bytes: " + std::to_string(hostBus.dataBytes)),
+            std::string::npos)
+      << output;
+
+  StringPrint ppm;
+  wired.printPPM(ppm);
+  std::ifstream in(image, std::ios::binary);
+  std::stringstream saved;
+  saved << in.rdbuf();
+  EXPECT_EQ(saved.str(), ppm.text);
+}
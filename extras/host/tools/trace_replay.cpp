@@ -0,0 +1,104 @@
+/*
+ * Replays a bus trace dumped by SSD1331_TraceRecorder (e.g. with the 'd'
+ * command of the commandTrace example) on a PC:
+ *
+ *   trace_replay [-o image.ppm] [-g gap_us] [trace.txt]
+ *
+ * The trace is read from the file, or from stdin, and replayed into an
+ * SSD1331_Emulator and an SSD1331_TimingModel. It prints the image
+ * checksum, as commandTrace's 'r' command does, the places where the bus
+ * sat idle for at least gap_us (100 by default), and the bytes sent with
+ * how long they take at common SPI clocks. -o saves the image.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <Adafruit_SSD1331.h>
+#include <Adafruit_SSD1331_Emulator.h>
+#include <Adafruit_SSD1331_Timing.h>
+#include <Adafruit_SSD1331_Trace.h>
+
+/// A Print that writes to a file
+class FilePrint : public Print {
+public:
+  FilePrint(FILE *f) : f(f) {}
+  size_t write(uint8_t c) { return fputc(c, f) == EOF ? 0 : 1; }
+  using Print::write;
+
+private:
+  FILE *f;
+};
+
+static const uint32_t clocks[] = {4000000, 8000000, 16000000, 24000000};
+static const SSD1331_McuProfile mcus[] = {SSD1331_MCU_AVR, SSD1331_MCU_SAMD21,
+                                          SSD1331_MCU_ESP32};
+
+static int usage(const char *name) {
+  fprintf(stderr, "Usage: %s [-o image.ppm] [-g gap_us] [trace.txt]\n",
+          name);
+  return 2;
+}
+
+int main(int argc, char **argv) {
+  const char *image = NULL;
+  uint32_t minGap = 100;
+  int opt;
+  while ((opt = getopt(argc, argv, "o:g:")) != -1) {
+    if (opt == 'o')
+      image = optarg;
+    else if (opt == 'g')
+      minGap = strtoul(optarg, NULL, 0);
+    else
+      return usage(argv[0]);
+  }
+  if (argc - optind > 1)
+    return usage(argv[0]);
+
+  FILE *in = stdin;
+  if (optind < argc && !(in = fopen(argv[optind], "r"))) {
+    perror(argv[optind]);
+    return 1;
+  }
+  // As large as the recorder allows, to hold a dump from any board
+  SSD1331_TraceRecorder trace(4096, 65535);
+  for (int c; (c = fgetc(in)) != EOF;)
+    trace.parse(c);
+  trace.parse('\n'); // In case the last line has no end
+  if (in != stdin)
+    fclose(in);
+  if (trace.dropped())
+    fprintf(stderr, "Trace too long, the first %lu transactions are lost\n",
+            (unsigned long)trace.dropped());
+
+  SSD1331_Emulator emulator;
+  trace.replay(emulator);
+  Serial.print(trace.size());
+  Serial.println(" transactions");
+  Serial.print("Image CRC: 0x");
+  Serial.println(emulator.crc32(), HEX);
+  trace.printGaps(Serial, minGap);
+
+  SSD1331_TimingModel model;
+  trace.replay(model);
+  Serial.print("Command bytes: ");
+  Serial.println(model.commandBytes());
+  Serial.print("Data bytes: ");
+  Serial.println(model.dataBytes());
+  Serial.print("Engine wait (us): ");
+  Serial.println(model.engineMicros());
+  model.printTable(Serial, clocks, 4, mcus, 3);
+
+  if (image) {
+    FILE *out = fopen(image, "wb");
+    if (!out) {
+      perror(image);
+      return 1;
+    }
+    FilePrint p(out);
+    emulator.printPPM(p);
+    fclose(out);
+  }
+  return 0;
+}